@@ -71,7 +71,7 @@ void setupCircleVAO(float x, float y, float radius, int segments, std::vector<gl
         colors.push_back(borderColor); // 边缘颜色
     }
 
-    glBindVertexArray(VAO);
+    GLState::get().bindVertexArray(VAO);
 
     // 设置顶点数据
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -86,7 +86,7 @@ void setupCircleVAO(float x, float y, float radius, int segments, std::vector<gl
     glEnableVertexAttribArray(1);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLState::get().bindVertexArray(0);
 }
 
 
@@ -127,7 +127,7 @@ GLuint loadTexture(const char* filePath) {
     // create texture
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLState::get().bindTexture(textureID);
 
     if (data == nullptr) {
         std::cerr << "Failed to load texture: " << filePath << std::endl;
@@ -287,7 +287,7 @@ int main() {
     // ----------------
     // enable blend
     glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::get().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // build and compile our shader zprogram
     // -------------------------------------
@@ -315,7 +315,7 @@ int main() {
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
-    glBindVertexArray(VAO);
+    GLState::get().bindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
@@ -382,7 +382,7 @@ int main() {
     glGenBuffers(1, &VBO1);
     glGenBuffers(1, &EBO1);
 
-    glBindVertexArray(VAO1);
+    GLState::get().bindVertexArray(VAO1);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO1);
     glBufferData(GL_ARRAY_BUFFER, sizeof(verticesCharacter), verticesCharacter, GL_STATIC_DRAW);
@@ -479,6 +479,8 @@ int main() {
         // deal with events
         // poll IO events(keys pressed/released, mouse moved etc.)
         glfwPollEvents();  
+        // count skipped state changes per frame
+        GLState::get().beginFrame();
 
         // start new ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -521,21 +523,20 @@ int main() {
                 backgroundShader.activate();
                 // bind texture on corresponding texture units
                 // glActiveTexture(GL_TEXTURE2);
-                glBindTexture(GL_TEXTURE_2D, texture);
+                GLState::get().bindTexture(texture);
 
                 // render container
-                glBindVertexArray(VAO);
+                GLState::get().bindVertexArray(VAO);
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                glBindVertexArray(0);
 
                 characterShader.activate();
-                glActiveTexture(GL_TEXTURE0);
+                GLState::get().activeTexture(GL_TEXTURE0);
                 // glBindTexture(GL_TEXTURE_2D, texture_playerShadow);
                 // glActiveTexture(GL_TEXTURE1);
                 if (facing_left)
-                    glBindTexture(GL_TEXTURE_2D, img_player_left[idx_current_anim]);
+                    GLState::get().bindTexture(img_player_left[idx_current_anim]);
                 else
-                    glBindTexture(GL_TEXTURE_2D, img_player_right[idx_current_anim]);
+                    GLState::get().bindTexture(img_player_right[idx_current_anim]);
 
                 if (player_pos.x < -1.0f) player_pos.x = -1.0f;
                 if (player_pos.x > 1.0f) player_pos.x = 1.0f;
@@ -547,9 +548,8 @@ int main() {
                 // set the texture value in the shader
                 characterShader.setMat4("model", model);
 
-                glBindVertexArray(VAO1);
+                GLState::get().bindVertexArray(VAO1);
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                glBindVertexArray(0);
 
                 // draw game
 
@@ -558,17 +558,16 @@ int main() {
                 for (Enemy* enemy : enemy_list)
                 {
                     if (enemy->facing_left)
-                        glBindTexture(GL_TEXTURE_2D, img_enemy_left[idx_current_anim]);
+                        GLState::get().bindTexture(img_enemy_left[idx_current_anim]);
                     else 
-                        glBindTexture(GL_TEXTURE_2D, img_enemy_right[idx_current_anim]);
+                        GLState::get().bindTexture(img_enemy_right[idx_current_anim]);
 
                     enemy->move(player_pos);
                     glm::mat4 model_enemy = glm::mat4(1.0f);
                     model_enemy = glm::translate(model_enemy, enemy->position);
                     characterShader.setMat4("model", model_enemy);
-                    glBindVertexArray(VAO1);
+                    GLState::get().bindVertexArray(VAO1);
                     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                    glBindVertexArray(0);
                 }
 
                 // bullet
@@ -579,9 +578,8 @@ int main() {
                     glm::mat4 model_bullet = glm::mat4(1.0f);
                     model_bullet = glm::translate(model_bullet, bullet.position);
                     characterShader.setMat4("model", model_bullet);
-                    glBindVertexArray(circleVAO);
+                    GLState::get().bindVertexArray(circleVAO);
                     glDrawArrays(GL_TRIANGLE_FAN, 0, verticesCircle.size());
-                    glBindVertexArray(0);      
                 }
                 // check bullet with enemy collision
                 for (Enemy* enemy : enemy_list)
@@ -612,11 +610,10 @@ int main() {
             {
                 // menu background
                 menuBackgroundShader.activate();
-                glBindTexture(GL_TEXTURE_2D, menu_texture);
+                GLState::get().bindTexture(menu_texture);
                 
-                glBindVertexArray(VAO);
+                GLState::get().bindVertexArray(VAO);
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                glBindVertexArray(0);
                 // button
                 scale = glm::vec3(0.12f, 0.13f, 1.0f);
                 offset = glm::vec3(-3.0f, -2.2f, 0.0f);
@@ -624,11 +621,10 @@ int main() {
                 button_model = glm::scale(button_model, scale);
                 button_model = glm::translate(button_model, offset);
                 buttonShader.activate();
-                glBindTexture(GL_TEXTURE_2D, start_button_idle_texture);
+                GLState::get().bindTexture(start_button_idle_texture);
                 buttonShader.setMat4("model", button_model);
-                glBindVertexArray(VAO);
+                GLState::get().bindVertexArray(VAO);
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                glBindVertexArray(0);
 
                 scale = glm::vec3(0.12f, 0.13f, 1.0f);
                 offset = glm::vec3(3.0f, -2.2f, 0.0f);
@@ -636,11 +632,10 @@ int main() {
                 button_model = glm::scale(button_model, scale);
                 button_model = glm::translate(button_model, offset);
                 buttonShader.activate();
-                glBindTexture(GL_TEXTURE_2D, quit_button_idle_texture);
+                GLState::get().bindTexture(quit_button_idle_texture);
                 buttonShader.setMat4("model", button_model);
-                glBindVertexArray(VAO);
+                GLState::get().bindVertexArray(VAO);
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                glBindVertexArray(0);     
 
                 double currentX, currentY;
                 glfwGetCursorPos(window, &currentX, &currentY);
@@ -653,11 +648,10 @@ int main() {
                     button_model = glm::scale(button_model, scale);
                     button_model = glm::translate(button_model, offset);
                     buttonShader.activate();
-                    glBindTexture(GL_TEXTURE_2D, start_button_hovered_texture);
+                    GLState::get().bindTexture(start_button_hovered_texture);
                     buttonShader.setMat4("model", button_model);
-                    glBindVertexArray(VAO);
+                    GLState::get().bindVertexArray(VAO);
                     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                    glBindVertexArray(0);
                     if (button_pressed)
                     {
                         is_game_started = true;
@@ -672,11 +666,10 @@ int main() {
                     button_model = glm::scale(button_model, scale);
                     button_model = glm::translate(button_model, offset);
                     buttonShader.activate();
-                    glBindTexture(GL_TEXTURE_2D, quit_button_hovered_texture);
+                    GLState::get().bindTexture(quit_button_hovered_texture);
                     buttonShader.setMat4("model", button_model);
-                    glBindVertexArray(VAO);
+                    GLState::get().bindVertexArray(VAO);
                     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                    glBindVertexArray(0);
                     if (button_pressed)
                     {
                         glfwSetWindowShouldClose(window, true);
@@ -712,6 +705,8 @@ int main() {
         // 渲染 ImGui
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        // ImGui binds its own program, VAO and texture; don't trust the shadowed state afterwards
+        GLState::get().invalidate();
 
         // glfw: swap buffers
         // ------------------
@@ -722,17 +717,17 @@ int main() {
     // clean up
     // --------
     // optional:de-allocate all resources once they've outlived their purpose
-    glDeleteVertexArrays(1, &VAO);
+    GLState::get().deleteVertexArray(VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
 
-    glDeleteVertexArrays(1, &VAO1);
+    GLState::get().deleteVertexArray(VAO1);
     glDeleteBuffers(1, &VBO1);
     glDeleteBuffers(1, &EBO1);
 
     glDeleteBuffers(1, &circleVBO);
     glDeleteBuffers(1, &colorVBO);
-    glDeleteVertexArrays(1, &circleVAO);
+    GLState::get().deleteVertexArray(circleVAO);
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -47,7 +47,7 @@ public:
             glDeleteProgram(iter.second.ID);
         // (properly) delete all textures
         for (auto iter : textures)
-            glDeleteTextures(1, &iter.second.ID);
+            GLState::get().deleteTexture(iter.second.ID);
     }
 private:
     // private constructor, that is we do not want any actual resource manager objects. Its members and functions should be publicly available (static).
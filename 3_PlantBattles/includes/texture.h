@@ -3,6 +3,8 @@
 
 #include <glad/glad.h>
 
+#include "gl_state.h"
+
 class Texture2D
 {
 public:
@@ -32,7 +34,7 @@ public:
         this->width = width;
         this->height = height;
         // create texture
-        glBindTexture(GL_TEXTURE_2D, this->ID);
+        GLState::get().bindTexture(this->ID);
         // target texture|texture mipmap level|texture internal format|texture width and height|border(usually 0)|pixel data format|pixel data type|texture data
         glTexImage2D(GL_TEXTURE_2D, 0, this->internal_format, width, height, 0, this->image_format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
@@ -41,14 +43,12 @@ public:
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->wrap_t); // vertical wrapping method
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->filter_min); // min filter method
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->filter_max); // magnify filter method
-        // unbind texture
-        glBindTexture(GL_TEXTURE_2D, 0);
     }
 
     // bind the texture as the current active GL_TEXTURE_2D texture object
     void bind() const
     {
-        glBindTexture(GL_TEXTURE_2D, this->ID);
+        GLState::get().bindTexture(this->ID);
     }
 };
 
@@ -0,0 +1,53 @@
+#ifndef FRAME_DATA_H
+#define FRAME_DATA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// CPU side copy of the std140 FrameData uniform block declared in
+// shaders/frame_data.glsl; member order and padding must match it.
+struct FrameDataBlock {
+    glm::mat4 Projection;
+    glm::vec4 Screen;    // <width, height, 1 / width, 1 / height>
+    float     Time;
+    float     padding[3];
+};
+
+// FrameData owns the uniform buffer behind the FrameData block. The buffer
+// stays bound to a fixed binding point, so every program that includes
+// frame_data.glsl sees the same values after one upload per frame.
+class FrameData
+{
+public:
+    // uniform buffer binding point of the FrameData block
+    static const unsigned int BINDING = 0;
+
+    FrameDataBlock Data;
+
+    FrameData()
+    {
+        glGenBuffers(1, &this->UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameDataBlock), NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, this->UBO);
+    }
+    ~FrameData()
+    {
+        glDeleteBuffers(1, &this->UBO);
+    }
+    // uploads this frame's data with a single buffer update
+    void Update(const glm::mat4 &projection, float width, float height, float time)
+    {
+        this->Data.Projection = projection;
+        this->Data.Screen = glm::vec4(width, height, 1.0f / width, 1.0f / height);
+        this->Data.Time = time;
+        glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameDataBlock), &this->Data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+private:
+    unsigned int UBO;
+};
+
+#endif
@@ -0,0 +1,296 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+// A finished CPU or GPU scope on the trace timeline
+struct ProfileEvent {
+    const char  *Name;
+    double       Start, Duration; // microseconds since the profiler was created
+    unsigned int Depth;           // nesting level within its thread (or the GPU)
+    unsigned int Thread;          // 0 is the GPU timeline
+};
+
+// One line of the rolling summary: a scope's time per frame averaged over a window
+struct ProfileSummaryEntry {
+    const char  *Name;
+    unsigned int Depth;
+    double       CpuMs, GpuMs;
+};
+
+// Profiler records nested CPU and GPU scopes and streams them to a Chrome
+// trace file (load it in chrome://tracing or ui.perfetto.dev). CPU scopes
+// may be entered from any thread. GPU scopes must be entered on the thread
+// owning the context; they are bracketed by GL_TIMESTAMP queries from a
+// pool, and a frame's queries are only read back GPU_FRAME_LATENCY frames
+// later so reading them never stalls the pipeline. Every SUMMARY_FRAMES
+// frames the per-frame averages are published to Summary for an in-game
+// overlay.
+// Use the PROFILE_* macros below instead of calling it directly; they
+// compile to nothing unless ENABLE_PROFILING is defined.
+class Profiler
+{
+public:
+    static const unsigned int GPU_FRAME_LATENCY = 3;
+    static const unsigned int SUMMARY_FRAMES = 60;
+    // averages of the last complete window, in the order the scopes were first entered
+    std::vector<ProfileSummaryEntry> Summary;
+    double       FrameMs;
+    // frames whose GPU queries were still not available when their slot was needed again
+    unsigned int DroppedGpuFrames;
+
+    static Profiler &get()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+    ~Profiler()
+    {
+        // no GL calls here; the context is gone by the time statics are destroyed
+        if (this->trace.is_open())
+            this->trace << "\n]\n";
+    }
+    // starts streaming all events to a trace file
+    void Open(const std::string &file)
+    {
+        this->trace.open(file, std::ios::trunc);
+        if (!this->trace)
+        {
+            std::cout << "ERROR::PROFILER: Failed to open " << file << std::endl;
+            return;
+        }
+        this->trace << "[\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+    }
+    // microseconds since the profiler was created
+    double Now() const
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - this->origin).count();
+    }
+
+    // CPU scopes; Enter() returns the depth to hand back to Leave()
+    unsigned int Enter()
+    {
+        return cpuDepth()++;
+    }
+    void Leave(const char *name, double start, unsigned int depth)
+    {
+        cpuDepth() = depth;
+        ProfileEvent event = { name, start, this->Now() - start, depth, threadId() };
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->cpuEvents.push_back(event);
+    }
+
+    // GPU scopes
+    void BeginGpu(const char *name)
+    {
+        std::vector<GpuScope> &scopes = this->gpuFrames[this->gpuFrame];
+        GpuScope scope = { name, static_cast<unsigned int>(this->openGpu.size()), this->acquireQuery(), 0 };
+        glQueryCounter(scope.Begin, GL_TIMESTAMP);
+        this->openGpu.push_back(static_cast<unsigned int>(scopes.size()));
+        scopes.push_back(scope);
+    }
+    void EndGpu()
+    {
+        GpuScope &scope = this->gpuFrames[this->gpuFrame][this->openGpu.back()];
+        this->openGpu.pop_back();
+        scope.End = this->acquireQuery();
+        glQueryCounter(scope.End, GL_TIMESTAMP);
+    }
+
+    // closes the frame: writes its CPU events, reads back the GPU frame that is old enough and updates the summary
+    void EndFrame()
+    {
+        double now = this->Now();
+        this->frameTime += now - this->frameStart;
+        this->frameStart = now;
+        std::vector<ProfileEvent> events;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            events.swap(this->cpuEvents);
+        }
+        for (const ProfileEvent &event : events)
+        {
+            this->write(event, "cpu");
+            this->accumulate(event).Cpu += event.Duration;
+        }
+        // the slot recorded GPU_FRAME_LATENCY frames ago is reused next
+        this->gpuFrame = (this->gpuFrame + 1) % (GPU_FRAME_LATENCY + 1);
+        this->readGpuFrame(this->gpuFrames[this->gpuFrame]);
+        if (++this->frames == SUMMARY_FRAMES)
+            this->publishSummary();
+    }
+private:
+    struct GpuScope {
+        const char  *Name;
+        unsigned int Depth;
+        GLuint       Begin, End;
+    };
+    struct Accumulator {
+        const char  *Name;
+        unsigned int Depth;
+        double       Cpu, Gpu; // microseconds summed over the window
+    };
+    std::chrono::steady_clock::time_point origin;
+    std::ofstream trace;
+    std::mutex    mutex;
+    std::vector<ProfileEvent> cpuEvents;
+    // GPU state
+    std::vector<GpuScope>  gpuFrames[GPU_FRAME_LATENCY + 1];
+    unsigned int           gpuFrame;
+    std::vector<unsigned int> openGpu; // stack of scopes entered but not ended, indices into the current frame
+    std::vector<GLuint>    freeQueries;
+    double                 gpuOffset; // maps GPU timestamps onto the CPU timeline, in microseconds
+    bool                   gpuSynced;
+    // summary window; names are string literals, so the pointer identifies a scope
+    std::vector<Accumulator> accumulators;
+    std::unordered_map<const char*, unsigned int> accumulatorIndex;
+    unsigned int frames;
+    double       frameStart, frameTime;
+
+    Profiler()
+        : FrameMs(0.0), DroppedGpuFrames(0), origin(std::chrono::steady_clock::now()), gpuFrame(0), gpuOffset(0.0), gpuSynced(false), frames(0), frameStart(0.0), frameTime(0.0) {}
+    Profiler(const Profiler&) = delete;
+    Profiler &operator=(const Profiler&) = delete;
+
+    static unsigned int &cpuDepth()
+    {
+        thread_local unsigned int depth = 0;
+        return depth;
+    }
+    // small sequential ids read better in the trace than native thread handles
+    static unsigned int threadId()
+    {
+        static std::atomic<unsigned int> next(1);
+        thread_local unsigned int id = next++;
+        return id;
+    }
+    GLuint acquireQuery()
+    {
+        if (this->freeQueries.empty())
+        {
+            this->freeQueries.resize(64);
+            glGenQueries(64, this->freeQueries.data());
+        }
+        GLuint query = this->freeQueries.back();
+        this->freeQueries.pop_back();
+        return query;
+    }
+    void readGpuFrame(std::vector<GpuScope> &scopes)
+    {
+        if (scopes.empty())
+            return;
+        // timestamps complete in order, so the last query tells whether the whole frame is done
+        GLint available = 0;
+        glGetQueryObjectiv(scopes.back().End, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            ++this->DroppedGpuFrames;
+        else
+        {
+            if (!this->gpuSynced)
+            {
+                GLint64 gpuNow = 0;
+                glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+                this->gpuOffset = this->Now() - gpuNow / 1000.0;
+                this->gpuSynced = true;
+            }
+            for (const GpuScope &scope : scopes)
+            {
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(scope.Begin, GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(scope.End, GL_QUERY_RESULT, &end);
+                ProfileEvent event = { scope.Name, begin / 1000.0 + this->gpuOffset, (end - begin) / 1000.0, scope.Depth, 0 };
+                this->write(event, "gpu");
+                this->accumulate(event).Gpu += event.Duration;
+            }
+        }
+        for (const GpuScope &scope : scopes)
+        {
+            this->freeQueries.push_back(scope.Begin);
+            this->freeQueries.push_back(scope.End);
+        }
+        scopes.clear();
+    }
+    void write(const ProfileEvent &event, const char *category)
+    {
+        if (!this->trace.is_open())
+            return;
+        this->trace << ",\n{\"name\":\"";
+        for (const char *c = event.Name; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                this->trace << '\\';
+            this->trace << *c;
+        }
+        this->trace << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.Thread
+                    << ",\"ts\":" << event.Start << ",\"dur\":" << event.Duration << "}";
+    }
+    Accumulator &accumulate(const ProfileEvent &event)
+    {
+        auto iter = this->accumulatorIndex.find(event.Name);
+        if (iter != this->accumulatorIndex.end())
+            return this->accumulators[iter->second];
+        this->accumulatorIndex[event.Name] = static_cast<unsigned int>(this->accumulators.size());
+        this->accumulators.push_back({ event.Name, event.Depth, 0.0, 0.0 });
+        return this->accumulators.back();
+    }
+    void publishSummary()
+    {
+        double perFrame = 1.0 / (this->frames * 1000.0); // microseconds per window to milliseconds per frame
+        this->Summary.clear();
+        for (const Accumulator &accumulator : this->accumulators)
+            this->Summary.push_back({ accumulator.Name, accumulator.Depth, accumulator.Cpu * perFrame, accumulator.Gpu * perFrame });
+        this->FrameMs = this->frameTime * perFrame;
+        this->accumulators.clear();
+        this->accumulatorIndex.clear();
+        this->frames = 0;
+        this->frameTime = 0.0;
+        this->trace.flush();
+    }
+};
+
+// RAII helpers behind the macros
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char *name) : name(name), start(Profiler::get().Now()), depth(Profiler::get().Enter()) {}
+    ~ProfileScope() { Profiler::get().Leave(this->name, this->start, this->depth); }
+private:
+    const char  *name;
+    double       start;
+    unsigned int depth;
+};
+class GpuProfileScope
+{
+public:
+    explicit GpuProfileScope(const char *name) { Profiler::get().BeginGpu(name); }
+    ~GpuProfileScope() { Profiler::get().EndGpu(); }
+};
+
+#ifdef ENABLE_PROFILING
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// times the rest of the enclosing block on the CPU; name must be a string literal
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+// times the GL commands issued in the rest of the enclosing block on the GPU
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+// call once per frame, after the frame's last GL command
+#define PROFILE_FRAME() Profiler::get().EndFrame()
+#define PROFILE_OPEN(file) Profiler::get().Open(file)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_OPEN(file) ((void)0)
+#endif
+
+#endif
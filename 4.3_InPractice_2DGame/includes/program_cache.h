@@ -0,0 +1,173 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "shader.h"
+
+// Stores linked shader programs on disk with glGetProgramBinary so later
+// launches can skip compiling and linking. Entries are keyed by a hash of
+// the shader sources and the driver's vendor, renderer and version
+// strings, so editing a shader or updating the driver simply misses the
+// cache. Whenever there is no usable binary, or the driver rejects one,
+// the program is compiled from source and the cache entry rewritten.
+class ProgramCache
+{
+public:
+    // statistics of this run
+    unsigned int Hits, Misses, Rejected;
+    double       LoadTime, CompileTime; // seconds spent loading binaries and compiling from source
+    double       SavedTime;             // compile time recorded in the cache entries that were hit, minus their load time
+
+    ProgramCache(std::string directory = "shader_cache")
+        : Hits(0), Misses(0), Rejected(0), LoadTime(0.0), CompileTime(0.0), SavedTime(0.0), directory(directory), initialized(false), supported(false) {}
+
+    // creates the program from the cache, or compiles it from source and stores it
+    void load(Shader &shader, const char *vertexSource, const char *fragmentSource, const char *geometrySource)
+    {
+        this->init();
+        if (!this->supported)
+        {
+            shader.compile(vertexSource, fragmentSource, geometrySource);
+            return;
+        }
+        std::string file = this->entryPath(vertexSource, fragmentSource, geometrySource);
+        auto start = std::chrono::steady_clock::now();
+        EntryHeader header;
+        std::vector<char> binary;
+        if (this->readEntry(file, header, binary))
+        {
+            if (shader.loadBinary(header.Format, binary.data(), static_cast<int>(binary.size())))
+            {
+                double elapsed = secondsSince(start);
+                ++this->Hits;
+                this->LoadTime += elapsed;
+                this->SavedTime += header.CompileMicroseconds / 1e6 - elapsed;
+                return;
+            }
+            ++this->Rejected;
+        }
+        ++this->Misses;
+        start = std::chrono::steady_clock::now();
+        shader.compile(vertexSource, fragmentSource, geometrySource, true);
+        double elapsed = secondsSince(start);
+        this->CompileTime += elapsed;
+        this->writeEntry(file, shader, elapsed);
+    }
+    // prints the statistics of this run
+    void report() const
+    {
+        unsigned int total = this->Hits + this->Misses;
+        if (!this->supported || total == 0)
+            return;
+        std::cout << std::fixed << std::setprecision(1)
+                  << "SHADER::CACHE: " << this->Hits << "/" << total << " programs loaded from binaries (" << 100.0 * this->Hits / total << "%), "
+                  << this->Rejected << " rejected; " << this->LoadTime * 1e3 << " ms loading, " << this->CompileTime * 1e3 << " ms compiling, ~"
+                  << this->SavedTime * 1e3 << " ms saved" << std::defaultfloat << std::endl;
+    }
+private:
+    // layout of the start of every cache file, followed by the program binary
+    struct EntryHeader {
+        uint32_t Magic;
+        uint32_t Format;
+        uint32_t Length;
+        uint32_t CompileMicroseconds;
+    };
+    static const uint32_t MAGIC = 0x31425250; // "PRB1"
+
+    std::string directory;
+    std::string driver;
+    bool        initialized, supported;
+
+    // checks for program binary support and creates the cache directory; needs a current context
+    void init()
+    {
+        if (this->initialized)
+            return;
+        this->initialized = true;
+        // glad only loads the program binary entry points for a 4.1 context; on 3.3 they stay null
+        if (!GLAD_GL_VERSION_4_1 || !glad_glProgramBinary || !glad_glGetProgramBinary || !glad_glProgramParameteri)
+        {
+            std::cout << "SHADER::CACHE: disabled, program binaries need OpenGL 4.1; compiling from source" << std::endl;
+            return;
+        }
+        int formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        std::error_code error;
+        std::filesystem::create_directories(this->directory, error);
+        this->supported = formats > 0 && !error;
+        if (!this->supported)
+        {
+            std::cout << "SHADER::CACHE: disabled, " << (error ? "can't create " + this->directory : std::string("the driver offers no binary formats")) << "; compiling from source" << std::endl;
+            return;
+        }
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const GLubyte *value = glGetString(name);
+            this->driver += value ? reinterpret_cast<const char*>(value) : "";
+            this->driver += '\n';
+        }
+    }
+    // cache file of a set of sources on the current driver
+    std::string entryPath(const char *vertexSource, const char *fragmentSource, const char *geometrySource) const
+    {
+        uint64_t hash = 14695981039346656037ull; // FNV-1a
+        auto mix = [&hash](const char *text) {
+            for (const char *c = text; c && *c; ++c)
+                hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+            // separate the strings so moving text between stages changes the key
+            hash = (hash ^ 0xFFu) * 1099511628211ull;
+        };
+        mix(vertexSource);
+        mix(fragmentSource);
+        mix(geometrySource);
+        mix(this->driver.c_str());
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+        return this->directory + "/" + name;
+    }
+    bool readEntry(const std::string &file, EntryHeader &header, std::vector<char> &binary) const
+    {
+        std::ifstream input(file, std::ios::binary);
+        if (!input || !input.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.Magic != MAGIC)
+            return false;
+        binary.resize(header.Length);
+        return static_cast<bool>(input.read(binary.data(), header.Length));
+    }
+    void writeEntry(const std::string &file, const Shader &shader, double compileTime) const
+    {
+        int length = 0;
+        glGetProgramiv(shader.ID, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        EntryHeader header;
+        GLenum format = 0;
+        glGetProgramBinary(shader.ID, length, &length, &format, binary.data());
+        header.Magic = MAGIC;
+        header.Format = format;
+        header.Length = static_cast<uint32_t>(length);
+        header.CompileMicroseconds = static_cast<uint32_t>(compileTime * 1e6);
+        std::ofstream output(file, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        output.write(binary.data(), length);
+        if (!output)
+            std::cout << "ERROR::SHADER::CACHE: Failed to write " << file << std::endl;
+    }
+    static double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+#endif
@@ -17,7 +17,7 @@ public:
         //---------------------------------------------------------------------------
         // setup VAO
         glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
+        GLState::get().bindVertexArray(VAO);
 
         // setup VBO;
         // set up vertex data(and buffers) and configure vertex attributes 
@@ -50,7 +50,7 @@ public:
         glEnableVertexAttribArray(1);
 
         // unbind VAO, VBO, EBO
-        glBindVertexArray(0);
+        GLState::get().bindVertexArray(0);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
@@ -60,16 +60,15 @@ public:
     {
         glDeleteBuffers(1, &VBO);
         glDeleteBuffers(1, &EBO);
-        glDeleteVertexArrays(1, &VAO);
+        GLState::get().deleteVertexArray(VAO);
     }
 
     void draw(const Shader& shader) const
     {
+        // program and VAO stay bound, so drawing several rectangles in a row binds them once
         shader.activate();
-        glBindVertexArray(VAO);
+        GLState::get().bindVertexArray(VAO);
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-        shader.deactivate();
     }
 };
 
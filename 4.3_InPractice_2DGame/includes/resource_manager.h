@@ -7,9 +7,32 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "texture.h"
+#include "texture_atlas.h"
 #include "shader.h"
+#include "frame_data.h"
+#include "program_cache.h"
+
+// A shader source with optional features that are switched on by
+// #define. Every combination of features (a bitmask, feature i being bit
+// i) is compiled into its own program the first time it is requested.
+struct ShaderVariants {
+    std::string                  Vertex, Fragment, Geometry;
+    bool                         HasGeometry;
+    std::vector<std::string>     Features;
+    std::map<unsigned int, Shader> Programs; // permutations built so far
+
+    // bit of a feature in a variant key, 0 if the shader doesn't have it
+    unsigned int key(const std::string &feature) const
+    {
+        for (unsigned int i = 0; i < this->Features.size(); ++i)
+            if (this->Features[i] == feature)
+                return 1u << i;
+        return 0;
+    }
+};
 
 class ResourceManager
 {
@@ -17,6 +40,10 @@ public:
     // resource storage
     inline static std::map<std::string, Shader> shaders;
     inline static std::map<std::string, Texture2D> textures;
+    inline static std::map<std::string, AtlasSprite> sprites;
+    inline static std::map<std::string, ShaderVariants> variants;
+    // linked programs saved on disk between runs
+    inline static ProgramCache programs;
     // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader
     static Shader loadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name)
     {
@@ -28,6 +55,38 @@ public:
     {
         return shaders[name];
     }
+    // loads the sources of a shader whose features can be toggled by #define; nothing is compiled until a variant is requested
+    static ShaderVariants &loadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name, std::vector<std::string> features)
+    {
+        ShaderVariants &shader = variants[name];
+        for (auto &program : shader.Programs)
+            glDeleteProgram(program.second.ID);
+        shader.Programs.clear();
+        shader.Vertex = loadSourceFromFile(vShaderFile);
+        shader.Fragment = loadSourceFromFile(fShaderFile);
+        shader.HasGeometry = gShaderFile != nullptr;
+        shader.Geometry = shader.HasGeometry ? loadSourceFromFile(gShaderFile) : "";
+        shader.Features = features;
+        return shader;
+    }
+    // retrieves a variant of a shader loaded with features, compiling it on first use
+    static Shader getShader(std::string name, unsigned int variant)
+    {
+        ShaderVariants &shader = variants[name];
+        auto iter = shader.Programs.find(variant);
+        if (iter != shader.Programs.end())
+            return iter->second;
+        std::string defines;
+        for (unsigned int i = 0; i < shader.Features.size(); ++i)
+            if (variant & (1u << i))
+                defines += "#define " + shader.Features[i] + "\n";
+        std::string vertexCode = injectDefines(shader.Vertex, defines);
+        std::string fragmentCode = injectDefines(shader.Fragment, defines);
+        std::string geometryCode = injectDefines(shader.Geometry, defines);
+        Shader program = compileShader(vertexCode.c_str(), fragmentCode.c_str(), shader.HasGeometry ? geometryCode.c_str() : nullptr);
+        shader.Programs[variant] = program;
+        return program;
+    }
     // loads and generates a texture from file
     static Texture2D loadTexture(const char *file, bool alpha, std::string name)
     {
@@ -39,15 +98,43 @@ public:
     {
         return textures[name];
     }
+    // loads a list of images and packs them into one or more atlas pages; the pages are stored as textures named name_0, name_1, ...
+    static void loadAtlas(const std::vector<AtlasSource> &sources, std::string name, unsigned int pageSize = 1024)
+    {
+        std::vector<AtlasImage> images;
+        for (const AtlasSource &source : sources)
+        {
+            AtlasImage image;
+            if (loadImageFromFile(source.File.c_str(), source.Alpha, image))
+            {
+                image.Name = source.Name;
+                images.push_back(image);
+            }
+        }
+        TextureAtlas atlas(pageSize);
+        atlas.build(images);
+        for (unsigned int i = 0; i < atlas.Pages.size(); ++i)
+            textures[name + "_" + std::to_string(i)] = atlas.Pages[i];
+        for (auto &sprite : atlas.Sprites)
+            sprites[sprite.first] = sprite.second;
+    }
+    // retrieves a stored atlas sprite (atlas page plus UV rect)
+    static AtlasSprite &getSprite(std::string name)
+    {
+        return sprites[name];
+    }
     // properly de-allocates all loaded resources
     static void clear()
     {
         // (properly) delete all shader
         for (auto iter : shaders)
             glDeleteProgram(iter.second.ID);
+        for (auto &iter : variants)
+            for (auto &program : iter.second.Programs)
+                glDeleteProgram(program.second.ID);
         // (properly) delete all textures
         for (auto iter : textures)
-            glDeleteTextures(1, &iter.second.ID);
+            GLState::get().deleteTexture(iter.second.ID);
     }
 private:
     // private constructor, that is we do not want any actual resource manager objects. Its members and functions should be publicly available (static).
@@ -57,47 +144,74 @@ private:
     static Shader loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile = nullptr)
     {
         // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        try
-        {
-            // open file
-            std::ifstream vertexShaderFile(vShaderFile);
-            std::ifstream fragmentShaderFile(fShaderFile);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vertexShaderFile.rdbuf();
-            fShaderStream << fragmentShaderFile.rdbuf();
-            // close file handles
-            vertexShaderFile.close();
-            fragmentShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-            // if geometry shader path is present, also load a geometry shader
-            if (gShaderFile != nullptr)
-            {
-                std::ifstream geometryShaderFile(gShaderFile);
-                std::stringstream gShaderStream;
-                gShaderStream << geometryShaderFile.rdbuf();
-                geometryShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
-        }
-        catch(const std::exception& e)
+        std::string vertexCode = loadSourceFromFile(vShaderFile);
+        std::string fragmentCode = loadSourceFromFile(fShaderFile);
+        // if geometry shader path is present, also load a geometry shader
+        std::string geometryCode = gShaderFile != nullptr ? loadSourceFromFile(gShaderFile) : "";
+        // 2. now create shader object from source code
+        return compileShader(vertexCode.c_str(), fragmentCode.c_str(), gShaderFile != nullptr ? geometryCode.c_str() : nullptr);
+    }
+    // reads a shader source file, pulling in any #include'd files
+    static std::string loadSourceFromFile(const char *file)
+    {
+        std::ifstream shaderFile(file);
+        if (!shaderFile)
         {
-            // std::cerr << e.what() << '\n';
-            std::cout << "ERROR::SHADER: Failed to read shader files" << std::endl;
+            std::cout << "ERROR::SHADER: Failed to read shader file " << file << std::endl;
+            return "";
         }
-        const char *vShaderCode = vertexCode.c_str();
-        const char *fShaderCode = fragmentCode.c_str();
-        const char *gShaderCode = geometryCode.c_str();
-        // 2. now create shader object from source code
+        std::stringstream shaderStream;
+        shaderStream << shaderFile.rdbuf();
+        return resolveIncludes(shaderStream.str(), file);
+    }
+    // creates a program from sources, going through the program binary cache
+    static Shader compileShader(const char *vShaderCode, const char *fShaderCode, const char *gShaderCode)
+    {
         Shader shader;
-        shader.compile(vShaderCode, fShaderCode, gShaderFile != nullptr ? gShaderCode : nullptr);
+        programs.load(shader, vShaderCode, fShaderCode, gShaderCode);
+        shader.bindUniformBlock("FrameData", FrameData::BINDING);
         return shader;
     }
+    // inserts #define lines right after the #version directive, which has to stay first
+    static std::string injectDefines(const std::string &source, const std::string &defines)
+    {
+        if (defines.empty() || source.empty())
+            return source;
+        std::size_t version = source.find("#version");
+        std::size_t line = version != std::string::npos ? source.find('\n', version) : std::string::npos;
+        if (line == std::string::npos)
+            return defines + source;
+        return source.substr(0, line + 1) + defines + source.substr(line + 1);
+    }
+    // replaces every '#include "file"' line with the contents of file, relative to the including shader
+    static std::string resolveIncludes(const std::string &source, const std::string &path, unsigned int depth = 0)
+    {
+        std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+        std::stringstream input(source), output;
+        std::string line;
+        while (std::getline(input, line))
+        {
+            std::size_t first = line.find_first_not_of(" \t");
+            if (first != std::string::npos && line.compare(first, 8, "#include") == 0 && depth < 16)
+            {
+                std::size_t open = line.find('"', first);
+                std::size_t close = open != std::string::npos ? line.find('"', open + 1) : std::string::npos;
+                std::string file = close != std::string::npos ? directory + line.substr(open + 1, close - open - 1) : "";
+                std::ifstream includeFile(file);
+                if (file.empty() || !includeFile)
+                {
+                    std::cout << "ERROR::SHADER: Failed to include " << line << std::endl;
+                    continue;
+                }
+                std::stringstream includeStream;
+                includeStream << includeFile.rdbuf();
+                output << resolveIncludes(includeStream.str(), file, depth + 1) << '\n';
+            }
+            else
+                output << line << '\n';
+        }
+        return output.str();
+    }
     // load a single texture from file
     static Texture2D loadTextureFromFile(const char *file, bool alpha)
     {
@@ -118,6 +232,26 @@ private:
         stbi_image_free(data);
         return texture;
     }
+    // load a single image from file into RGBA pixels for atlas packing
+    static bool loadImageFromFile(const char *file, bool alpha, AtlasImage &image)
+    {
+        int width, height, nrChannels;
+        unsigned char *data = stbi_load(file, &width, &height, &nrChannels, 4);
+        if (!data)
+        {
+            std::cout << "ERROR::ATLAS: Failed to load image " << file << std::endl;
+            return false;
+        }
+        image.Width = width;
+        image.Height = height;
+        image.Pixels.assign(data, data + width * height * 4);
+        // images loaded without alpha are rendered fully opaque, whatever the file stores
+        if (!alpha)
+            for (unsigned int i = 3; i < image.Pixels.size(); i += 4)
+                image.Pixels[i] = 255;
+        stbi_image_free(data);
+        return true;
+    }
 };
 
 
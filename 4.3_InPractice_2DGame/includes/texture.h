@@ -3,6 +3,8 @@
 
 #include <glad/glad.h>
 
+#include "gl_state.h"
+
 class Texture2D
 {
 public:
@@ -20,9 +22,9 @@ public:
     unsigned int filter_max; // filter mode if ... > ...
 
 public:
-    Texture2D() : width(0), height(0), internal_format(GL_RGB), image_format(GL_RGB), wrap_s(GL_REPEAT), wrap_t(GL_REPEAT), filter_max(GL_LINEAR), filter_min(GL_LINEAR)
+    // the texture object is only created by generate(), so textureless objects can exist without a GL context
+    Texture2D() : ID(0), width(0), height(0), internal_format(GL_RGB), image_format(GL_RGB), wrap_s(GL_REPEAT), wrap_t(GL_REPEAT), filter_max(GL_LINEAR), filter_min(GL_LINEAR)
     {
-        glGenTextures(1, &this->ID);
     }
     ~Texture2D() = default;
 
@@ -32,7 +34,9 @@ public:
         this->width = width;
         this->height = height;
         // create texture
-        glBindTexture(GL_TEXTURE_2D, this->ID);
+        if (this->ID == 0)
+            glGenTextures(1, &this->ID);
+        GLState::get().bindTexture(this->ID);
         // target texture|texture mipmap level|texture internal format|texture width and height|border(usually 0)|pixel data format|pixel data type|texture data
         glTexImage2D(GL_TEXTURE_2D, 0, this->internal_format, width, height, 0, this->image_format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
@@ -41,14 +45,12 @@ public:
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->wrap_t); // vertical wrapping method
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->filter_min); // min filter method
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->filter_max); // magnify filter method
-        // unbind texture
-        glBindTexture(GL_TEXTURE_2D, 0);
     }
 
     // bind the texture as the current active GL_TEXTURE_2D texture object
     void bind() const
     {
-        glBindTexture(GL_TEXTURE_2D, this->ID);
+        GLState::get().bindTexture(this->ID);
     }
 };
 
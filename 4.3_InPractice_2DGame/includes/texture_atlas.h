@@ -0,0 +1,164 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "texture.h"
+
+// A named sub-rectangle of an atlas page
+struct AtlasSprite {
+    Texture2D Texture; // atlas page the sprite lives on
+    glm::vec4 UV;      // <vec2 offset, vec2 scale> of the sprite in normalized texture coordinates
+
+    AtlasSprite() : Texture(), UV(0.0f, 0.0f, 1.0f, 1.0f) {}
+    AtlasSprite(Texture2D texture, glm::vec4 uv) : Texture(texture), UV(uv) {}
+};
+
+// Packs rectangles into a fixed size page using rows of decreasing height
+// (shelf packing). Rectangles should be inserted sorted by height, tallest
+// first, for the best fit.
+class RectPacker
+{
+public:
+    RectPacker(unsigned int width, unsigned int height, unsigned int padding = 0)
+        : width(width), height(height), padding(padding)
+    {
+        this->reset();
+    }
+    // finds a spot for a width x height rectangle; returns false if the page is full
+    bool pack(unsigned int w, unsigned int h, glm::ivec2 &origin)
+    {
+        unsigned int paddedW = w + 2 * this->padding;
+        unsigned int paddedH = h + 2 * this->padding;
+        if (paddedW > this->width)
+            return false;
+        // start a new shelf below the current one if the rectangle doesn't fit on it
+        if (this->shelfX + paddedW > this->width || paddedH > this->shelfHeight)
+        {
+            this->shelfY += this->shelfHeight;
+            this->shelfX = 0;
+            this->shelfHeight = paddedH;
+        }
+        if (this->shelfY + paddedH > this->height)
+            return false;
+        origin = glm::ivec2(this->shelfX + this->padding, this->shelfY + this->padding);
+        this->shelfX += paddedW;
+        return true;
+    }
+    // height of the page covered by the shelves so far
+    unsigned int usedHeight() const
+    {
+        return this->shelfY + this->shelfHeight;
+    }
+    // empties the page
+    void reset()
+    {
+        this->shelfX = this->shelfY = this->shelfHeight = 0;
+    }
+private:
+    unsigned int width, height, padding;
+    unsigned int shelfX, shelfY, shelfHeight;
+};
+
+// An image file to be loaded into an atlas (mirrors the arguments of ResourceManager::loadTexture)
+struct AtlasSource {
+    std::string File;
+    bool        Alpha;
+    std::string Name;
+};
+
+// An image to be placed into an atlas
+struct AtlasImage {
+    std::string          Name;
+    unsigned int         Width, Height;
+    std::vector<GLubyte> Pixels; // tightly packed, RGBA when built into a TextureAtlas
+};
+
+// Builds one or more RGBA atlas pages out of a list of images. Each image
+// is surrounded by a border of duplicated edge texels so linear filtering
+// never bleeds neighbouring sprites into each other.
+class TextureAtlas
+{
+public:
+    // result of a build: the atlas pages and where every image ended up
+    std::vector<Texture2D>                          Pages;
+    std::vector<std::pair<std::string, AtlasSprite>> Sprites;
+
+    TextureAtlas(unsigned int pageSize = 1024, unsigned int padding = 2)
+        : pageSize(pageSize), padding(padding) {}
+
+    void build(std::vector<AtlasImage> images)
+    {
+        // tallest first gives the shelf packer the tightest rows
+        std::sort(images.begin(), images.end(), [](const AtlasImage &a, const AtlasImage &b) {
+            return a.Height > b.Height;
+        });
+        std::vector<GLubyte> page(this->pageSize * this->pageSize * 4, 0);
+        std::vector<std::pair<std::string, glm::vec4>> pageSprites;
+        RectPacker packer(this->pageSize, this->pageSize, this->padding);
+        for (const AtlasImage &image : images)
+        {
+            glm::ivec2 origin;
+            if (!packer.pack(image.Width, image.Height, origin))
+            {
+                // page is full; upload it and continue on a fresh one
+                this->flushPage(page, pageSprites);
+                packer.reset();
+                if (!packer.pack(image.Width, image.Height, origin))
+                {
+                    std::cout << "ERROR::ATLAS: Image does not fit into an atlas page: " << image.Name << std::endl;
+                    continue;
+                }
+            }
+            this->blit(page, image, origin);
+            float size = static_cast<float>(this->pageSize);
+            pageSprites.push_back(std::make_pair(image.Name, glm::vec4(origin.x / size, origin.y / size, image.Width / size, image.Height / size)));
+        }
+        this->flushPage(page, pageSprites);
+    }
+private:
+    unsigned int pageSize, padding;
+
+    // copies an image into the page and extrudes its edges into the padding
+    void blit(std::vector<GLubyte> &page, const AtlasImage &image, glm::ivec2 origin)
+    {
+        int pad = static_cast<int>(this->padding);
+        for (int y = -pad; y < static_cast<int>(image.Height) + pad; ++y)
+        {
+            int srcY = std::min(std::max(y, 0), static_cast<int>(image.Height) - 1);
+            for (int x = -pad; x < static_cast<int>(image.Width) + pad; ++x)
+            {
+                int srcX = std::min(std::max(x, 0), static_cast<int>(image.Width) - 1);
+                const GLubyte *src = &image.Pixels[(srcY * image.Width + srcX) * 4];
+                GLubyte *dst = &page[((origin.y + y) * this->pageSize + (origin.x + x)) * 4];
+                std::memcpy(dst, src, 4);
+            }
+        }
+    }
+    // uploads the page into a texture and records its sprites
+    void flushPage(std::vector<GLubyte> &page, std::vector<std::pair<std::string, glm::vec4>> &pageSprites)
+    {
+        if (pageSprites.empty())
+            return;
+        Texture2D texture;
+        texture.internal_format = GL_RGBA;
+        texture.image_format = GL_RGBA;
+        texture.wrap_s = GL_CLAMP_TO_EDGE;
+        texture.wrap_t = GL_CLAMP_TO_EDGE;
+        texture.generate(this->pageSize, this->pageSize, page.data());
+        this->Pages.push_back(texture);
+        for (auto &sprite : pageSprites)
+            this->Sprites.push_back(std::make_pair(sprite.first, AtlasSprite(texture, sprite.second)));
+        pageSprites.clear();
+        std::fill(page.begin(), page.end(), 0);
+    }
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that split loops of independent work items
+// between them. ParallelFor() blocks until every item has been processed;
+// the calling thread takes part in the work as well.
+class ThreadPool
+{
+public:
+    // creates threads - 1 workers; 0 picks one thread per hardware core
+    ThreadPool(unsigned int threads = 0)
+        : task(nullptr), count(0), generation(0), pending(0), stopping(false)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 1; i < threads; ++i)
+            this->workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->wake.notify_all();
+        for (std::thread &worker : this->workers)
+            worker.join();
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool &operator=(const ThreadPool&) = delete;
+
+    // number of threads taking part in ParallelFor, including the caller
+    unsigned int Size() const
+    {
+        return static_cast<unsigned int>(this->workers.size()) + 1;
+    }
+    // calls work(i) for every i in [0, n), spread over all threads
+    void ParallelFor(unsigned int n, const std::function<void(unsigned int)> &work)
+    {
+        if (n == 0)
+            return;
+        if (this->workers.empty() || n == 1)
+        {
+            for (unsigned int i = 0; i < n; ++i)
+                work(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->task = &work;
+            this->count = n;
+            this->next = 0;
+            this->pending = static_cast<unsigned int>(this->workers.size());
+            ++this->generation;
+        }
+        this->wake.notify_all();
+        this->runItems();
+        // wait until every worker has left the current loop
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->done.wait(lock, [this]() { return this->pending == 0; });
+        this->task = nullptr;
+    }
+private:
+    std::vector<std::thread> workers;
+    std::mutex               mutex;
+    std::condition_variable  wake, done;
+    // current loop
+    const std::function<void(unsigned int)> *task;
+    unsigned int              count;
+    std::atomic<unsigned int> next;
+    unsigned long long        generation;
+    unsigned int              pending;
+    bool                      stopping;
+
+    // grabs items of the current loop until none are left
+    void runItems()
+    {
+        for (unsigned int i = this->next++; i < this->count; i = this->next++)
+            (*this->task)(i);
+    }
+    void workerLoop()
+    {
+        unsigned long long seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->wake.wait(lock, [this, seen]() { return this->stopping || this->generation != seen; });
+                if (this->stopping)
+                    return;
+                seen = this->generation;
+            }
+            this->runItems();
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                --this->pending;
+            }
+            this->done.notify_one();
+        }
+    }
+};
+
+#endif
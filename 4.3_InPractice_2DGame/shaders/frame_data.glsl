@@ -0,0 +1,7 @@
+// per-frame data shared by all programs; mirrors FrameDataBlock in frame_data.h
+layout (std140) uniform FrameData
+{
+    mat4  projection;
+    vec4  screen;     // <width, height, 1 / width, 1 / height>
+    float time;
+};
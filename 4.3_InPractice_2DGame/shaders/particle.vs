@@ -1,12 +1,12 @@
 #version 330 core
 layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+layout (location = 1) in vec2 offset; // per-instance particle position
+layout (location = 2) in vec4 color;  // per-instance particle color
 
 out vec2 TexCoords;
 out vec4 ParticleColor;
 
-uniform mat4 projection;
-uniform vec2 offset;
-uniform vec4 color;
+#include "frame_data.glsl"
 
 void main()
 {
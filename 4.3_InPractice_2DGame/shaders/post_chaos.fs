@@ -0,0 +1,26 @@
+#version 330 core
+in vec2 TexCoords;
+out vec4 color;
+
+uniform sampler2D scene;
+
+// edge detection over the 3x3 neighbourhood of every texel
+const float offset = 1.0 / 300.0;
+const vec2 offsets[9] = vec2[](
+    vec2(-offset,  offset), vec2(0.0,  offset), vec2(offset,  offset),
+    vec2(-offset,  0.0),    vec2(0.0,  0.0),    vec2(offset,  0.0),
+    vec2(-offset, -offset), vec2(0.0, -offset), vec2(offset, -offset)
+);
+const float edge_kernel[9] = float[](
+    -1.0, -1.0, -1.0,
+    -1.0,  8.0, -1.0,
+    -1.0, -1.0, -1.0
+);
+
+void main()
+{
+    vec3 sum = vec3(0.0);
+    for(int i = 0; i < 9; i++)
+        sum += vec3(texture(scene, TexCoords + offsets[i])) * edge_kernel[i];
+    color = vec4(sum, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 330 core
+layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+
+out vec2 TexCoords;
+
+#include "frame_data.glsl"
+
+void main()
+{
+    gl_Position = vec4(vertex.xy, 0.0f, 1.0f); 
+    // swirl the scene around
+    float strength = 0.3;
+    TexCoords = vec2(vertex.z + sin(time) * strength, vertex.w + cos(time) * strength);
+}
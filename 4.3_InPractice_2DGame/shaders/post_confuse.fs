@@ -0,0 +1,11 @@
+#version 330 core
+in vec2 TexCoords;
+out vec4 color;
+
+uniform sampler2D scene;
+
+void main()
+{
+    // flip the scene upside down and invert its colors
+    color = vec4(1.0 - texture(scene, vec2(1.0) - TexCoords).rgb, 1.0);
+}
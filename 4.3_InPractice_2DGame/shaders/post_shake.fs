@@ -0,0 +1,33 @@
+#version 330 core
+in vec2 TexCoords;
+out vec4 color;
+
+uniform sampler2D scene;
+
+// gaussian blur over the 3x3 neighbourhood of every texel
+const float offset = 1.0 / 300.0;
+const vec2 offsets[9] = vec2[](
+    vec2(-offset,  offset), vec2(0.0,  offset), vec2(offset,  offset),
+    vec2(-offset,  0.0),    vec2(0.0,  0.0),    vec2(offset,  0.0),
+    vec2(-offset, -offset), vec2(0.0, -offset), vec2(offset, -offset)
+);
+const float blur_kernel[9] = float[](
+    1.0 / 16.0, 2.0 / 16.0, 1.0 / 16.0,
+    2.0 / 16.0, 4.0 / 16.0, 2.0 / 16.0,
+    1.0 / 16.0, 2.0 / 16.0, 1.0 / 16.0
+);
+
+void main()
+{
+    vec3 sum = vec3(0.0);
+    for(int i = 0; i < 9; i++)
+    {
+#ifdef LAST
+        sum += vec3(texture(scene, TexCoords + offsets[i])) * blur_kernel[i];
+#else
+        // shifted coordinates must not wrap around to the opposite edge
+        sum += vec3(texture(scene, clamp(TexCoords + offsets[i], 0.0, 1.0))) * blur_kernel[i];
+#endif
+    }
+    color = vec4(sum, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+
+out vec2 TexCoords;
+
+#include "frame_data.glsl"
+
+// LAST is defined for the variant drawing the final pass to the screen
+void main()
+{
+    gl_Position = vec4(vertex.xy, 0.0f, 1.0f); 
+    TexCoords = vertex.zw;
+    float strength = 0.01;
+    vec2 shake = vec2(cos(time * 10), cos(time * 15)) * strength;
+#ifdef LAST
+    // move the whole quad; the uncovered strip shows the cleared screen
+    gl_Position.xy += shake;
+#else
+    // an intermediate target keeps whatever the quad doesn't cover, so shift the coordinates instead
+    TexCoords -= shake * 0.5;
+#endif
+}
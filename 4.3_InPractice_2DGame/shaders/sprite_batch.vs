@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec4 vertex;        // <vec2 position, vec2 texCoords>
+layout (location = 1) in vec4 instanceRect;  // <vec2 position, vec2 size>
+layout (location = 2) in vec4 instanceStyle; // <vec3 color, float rotation>
+layout (location = 3) in vec4 instanceUV;    // <vec2 offset, vec2 scale> inside the (atlas) texture
+
+out vec2 TexCoords;
+out vec3 SpriteColor;
+
+#include "frame_data.glsl"
+
+void main()
+{
+    TexCoords = instanceUV.xy + vertex.zw * instanceUV.zw;
+    SpriteColor = instanceStyle.rgb;
+    // scale, then rotate around the center of the quad, then translate
+    vec2 local = (vertex.xy - 0.5) * instanceRect.zw;
+    float s = sin(instanceStyle.a);
+    float c = cos(instanceStyle.a);
+    vec2 rotated = vec2(c * local.x - s * local.y, s * local.x + c * local.y);
+    vec2 world = instanceRect.xy + 0.5 * instanceRect.zw + rotated;
+    gl_Position = projection * vec4(world, 0.0, 1.0);
+}
@@ -1,12 +1,19 @@
 #version 330 core
 in vec2 TexCoords;
+in vec3 TextColor;
 out vec4 color;
 
-uniform sampler2D text;
-uniform vec3 textColor;
+uniform sampler2D text; // glyph coverage, or a signed distance field (0.5 on the outline) with SDF defined
 
 void main()
 {    
+#ifdef SDF
+    float distance = texture(text, TexCoords).r;
+    // antialias over one screen pixel, whatever the scale the glyph is drawn at
+    float width = fwidth(distance);
+    vec4 sampled = vec4(1.0, 1.0, 1.0, smoothstep(0.5 - width, 0.5 + width, distance));
+#else
     vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-    color = vec4(textColor, 1.0) * sampled;
-}  
\ No newline at end of file
+#endif
+    color = vec4(TextColor, 1.0) * sampled;
+}
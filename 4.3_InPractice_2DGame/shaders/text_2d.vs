@@ -1,11 +1,16 @@
 #version 330 core
 layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+layout (location = 1) in vec3 color;
 out vec2 TexCoords;
+out vec3 TextColor;
 
-uniform mat4 projection;
+uniform vec2 offset; // origin of a retained layout, zero for streamed text
+
+#include "frame_data.glsl"
 
 void main()
 {
-    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+    gl_Position = projection * vec4(vertex.xy + offset, 0.0, 1.0);
     TexCoords = vertex.zw;
-} 
\ No newline at end of file
+    TextColor = color;
+}
@@ -13,6 +13,8 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 const unsigned int SCREEN_WIDTH = 800;
 // The height of the screen
 const unsigned int SCREEN_HEIGHT = 600;
+// Longest frame the simulation catches up on; anything beyond (window drags, breakpoints) is dropped
+const double MAX_FRAME_TIME = 0.25;
 
 void mouse_callback(GLFWwindow* window, int button, int action, int mods) {
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
@@ -46,6 +48,8 @@ int main() {
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); //核心模式，核心模式下不能使用glBegin()/glEnd()
     // glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE); //兼容核心模式
     glfwWindowHint(GLFW_RESIZABLE, false);
+    // MSAA lives in PostProcessor's offscreen buffer, which every frame is resolved from; a multisampled window would pay for it twice
+    glfwWindowHint(GLFW_SAMPLES, 0);
 
     // create GLFW window
     // ------------------
@@ -82,45 +86,50 @@ int main() {
     glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
     // enable blend
     glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::get().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // initialize game
     // ---------------
     Breakout.Init();
+    PROFILE_OPEN("breakout_trace.json");
 
-    // deltaTime variables
+    // timing variables; the simulation advances in fixed steps of Breakout.Timestep taken out
+    // of the accumulated frame time, rendering interpolates between the last two steps
     // -------------------
-    float deltaTime = 0.0f;
-    float lastFrame = 0.0f;
+    double lastFrame = glfwGetTime();
+    double accumulator = 0.0;
 
     // 主循环
     while (!glfwWindowShouldClose(window)) {
-        // calculate delta time
+        // accumulate frame time
         // --------------------
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
+        double currentFrame = glfwGetTime();
+        accumulator += std::min(currentFrame - lastFrame, MAX_FRAME_TIME);
         lastFrame = currentFrame;
         glfwPollEvents();
 
-        // manage user input
+        // manage user input and update game state, as many fixed steps as the frame time covers
         // -----------------
-        Breakout.ProcessInput(deltaTime);
-
-        // update game state
-        // -----------------
-        Breakout.Update(deltaTime);
+        while (accumulator >= Breakout.Timestep)
+        {
+            Breakout.Step();
+            accumulator -= Breakout.Timestep;
+        }
         
         // render
         // ------
+        // count skipped state changes per frame
+        GLState::get().beginFrame();
         // clear screen
         glClearColor(0.45f, 0.55f, 0.60f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
-        Breakout.Render();
+        Breakout.Render(static_cast<float>(accumulator / Breakout.Timestep));
 
         // glfw: swap buffers
         // ------------------
         // 交换缓冲区
         glfwSwapBuffers(window);
+        PROFILE_FRAME();
     }
 
     // delete all resources as loaded using the resource manager
@@ -1,5 +1,9 @@
 #ifndef BALLOBJECT_H
 #define BALLOBJECT_H
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
@@ -21,44 +25,136 @@ public:
     bool    Sticky, PassThrough;
     BallObject()
         : GameObject(), Radius(12.5f), Stuck(true), Sticky(false), PassThrough(false) {}
-    BallObject(glm::vec2 pos, float radius, glm::vec2 velocity, Texture2D sprite)
+    BallObject(glm::vec2 pos, float radius, glm::vec2 velocity)
+        : GameObject(pos, glm::vec2(radius * 2.0f, radius * 2.0f), glm::vec3(1.0f), velocity), Radius(radius), Stuck(true), Sticky(false), PassThrough(false) {}
+    BallObject(glm::vec2 pos, float radius, glm::vec2 velocity, const AtlasSprite &sprite)
         : GameObject(pos, glm::vec2(radius * 2.0f, radius * 2.0f), sprite, glm::vec3(1.0f), velocity), Radius(radius), Stuck(true), Sticky(false), PassThrough(false)
     {
 
     }
     ~BallObject(){}
 
-    // moves the ball, keeping it constrained within the window bounds (except bottom edge); returns new position
-    glm::vec2 Move(float dt, unsigned int window_width)
+    // Swept collision tests. motion is how far the ball would travel; on a
+    // hit, time is the fraction of motion after which the ball touches the
+    // obstacle and normal points from the obstacle towards the ball. A ball
+    // that already overlaps an obstacle hits it at time 0, unless it is
+    // moving away from it.
+
+    // The static versions take the ball's top-left position and radius, so
+    // balls that aren't BallObjects (see BallSet) can use them as well.
+    bool Sweep(glm::vec2 motion, glm::vec2 boxMin, glm::vec2 boxMax, float &time, glm::vec2 &normal) const
+    {
+        return Sweep(this->Position, this->Radius, motion, boxMin, boxMax, time, normal);
+    }
+    bool SweepWalls(glm::vec2 motion, float width, float &time, glm::vec2 &normal) const
+    {
+        return SweepWalls(this->Position, this->Radius, motion, width, time, normal);
+    }
+    // against the box [boxMin, boxMax]: a ray from the ball's center against the box grown by the radius, with rounded corners
+    static bool Sweep(glm::vec2 position, float radius, glm::vec2 motion, glm::vec2 boxMin, glm::vec2 boxMax, float &time, glm::vec2 &normal)
     {
-        // if not stuck to player board
-        if (!this->Stuck)
+        glm::vec2 center = position + radius;
+        glm::vec2 offset = center - glm::clamp(center, boxMin, boxMax);
+        float distance2 = glm::dot(offset, offset);
+        if (distance2 < radius * radius)
         {
-            // move the ball
-            this->Position += this->Velocity * dt;
-            // then check if outside window bounds and if so, reverse velocity and restore at correct position
-            if (this->Position.x <= 0.0f)
+            if (distance2 > 0.0f)
+                normal = offset / std::sqrt(distance2);
+            else
             {
-                this->Velocity.x = -this->Velocity.x;
-                this->Position.x = 0.0f;
+                // center inside the box: push out through the nearest face
+                float left = center.x - boxMin.x, right = boxMax.x - center.x, top = center.y - boxMin.y, bottom = boxMax.y - center.y;
+                float nearest = std::min(std::min(left, right), std::min(top, bottom));
+                normal = nearest == left ? glm::vec2(-1.0f, 0.0f) : nearest == right ? glm::vec2(1.0f, 0.0f) : nearest == top ? glm::vec2(0.0f, -1.0f) : glm::vec2(0.0f, 1.0f);
             }
-            else if (this->Position.x + this->Size.x >= window_width)
+            if (glm::dot(motion, normal) >= 0.0f)
+                return false;
+            time = 0.0f;
+            return true;
+        }
+        // slab test against the grown box
+        glm::vec2 lo = boxMin - radius, hi = boxMax + radius;
+        float enter = 0.0f, exit = 1.0f;
+        int axis = -1;
+        for (int a = 0; a < 2; ++a)
+        {
+            if (motion[a] == 0.0f)
             {
-                this->Velocity.x = -this->Velocity.x;
-                this->Position.x = window_width - this->Size.x;
+                if (center[a] < lo[a] || center[a] > hi[a])
+                    return false;
+                continue;
             }
-            if (this->Position.y <= 0.0f)
+            float t0 = (lo[a] - center[a]) / motion[a], t1 = (hi[a] - center[a]) / motion[a];
+            if (t0 > t1)
+                std::swap(t0, t1);
+            if (t0 > enter)
             {
-                this->Velocity.y = -this->Velocity.y;
-                this->Position.y = 0.0f;
+                enter = t0;
+                axis = a;
             }
+            exit = std::min(exit, t1);
+            if (enter > exit)
+                return false;
+        }
+        glm::vec2 contact = center + motion * enter;
+        bool outsideX = contact.x < boxMin.x || contact.x > boxMax.x;
+        bool outsideY = contact.y < boxMin.y || contact.y > boxMax.y;
+        if (outsideX && outsideY)
+        {
+            // entered the grown box next to a corner, where it is rounded: test against a circle around the corner
+            glm::vec2 corner(contact.x < boxMin.x ? boxMin.x : boxMax.x, contact.y < boxMin.y ? boxMin.y : boxMax.y);
+            glm::vec2 d = center - corner;
+            float a = glm::dot(motion, motion), b = glm::dot(d, motion), c = glm::dot(d, d) - radius * radius;
+            float discriminant = b * b - a * c;
+            if (a == 0.0f || discriminant < 0.0f)
+                return false;
+            float t = (-b - std::sqrt(discriminant)) / a;
+            if (t < 0.0f || t > 1.0f)
+                return false;
+            time = t;
+            normal = (d + motion * t) / radius;
+            return true;
+        }
+        if (axis < 0)
+            return false;
+        time = enter;
+        normal = glm::vec2(0.0f, 0.0f);
+        normal[axis] = motion[axis] > 0.0f ? -1.0f : 1.0f;
+        return true;
+    }
+    // against the left, right and top edges of a window of the given width (the bottom is open)
+    static bool SweepWalls(glm::vec2 position, float radius, glm::vec2 motion, float width, float &time, glm::vec2 &normal)
+    {
+        bool hit = false;
+        time = 2.0f;
+        float t;
+        if (motion.x < 0.0f && (t = std::max(-position.x / motion.x, 0.0f)) <= 1.0f && t < time)
+        {
+            time = t; normal = glm::vec2(1.0f, 0.0f); hit = true;
         }
-        return this->Position;    
+        if (motion.x > 0.0f && (t = std::max((width - radius * 2.0f - position.x) / motion.x, 0.0f)) <= 1.0f && t < time)
+        {
+            time = t; normal = glm::vec2(-1.0f, 0.0f); hit = true;
+        }
+        if (motion.y < 0.0f && (t = std::max(-position.y / motion.y, 0.0f)) <= 1.0f && t < time)
+        {
+            time = t; normal = glm::vec2(0.0f, 1.0f); hit = true;
+        }
+        return hit;
+    }
+    // mirrors the velocity at a surface with the given normal
+    void Bounce(glm::vec2 normal)
+    {
+        this->Velocity = Reflect(this->Velocity, normal);
+    }
+    static glm::vec2 Reflect(glm::vec2 velocity, glm::vec2 normal)
+    {
+        return velocity - normal * (2.0f * glm::dot(velocity, normal));
     }
     // resets the ball to original state with given position and velocity
     void Reset(glm::vec2 position, glm::vec2 velocity)
     {
-        this->Position = position;
+        this->Position = this->PrevPosition = position;
         this->Velocity = velocity;
         this->Stuck = true;
         this->Sticky = false;
@@ -0,0 +1,53 @@
+#ifndef BALL_SET_H
+#define BALL_SET_H
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game_constants.h"
+
+// BallSet holds the extra balls of multi-ball play as a structure of
+// arrays. All of them share one radius and the pass-through state of
+// the player's BallObject; they never stick to the paddle. Like
+// ParticlePool, the balls always occupy the first Count() slots and a
+// ball is removed by moving the last one into its slot. Positions are the
+// top-left corners of the balls, like GameObject's.
+class BallSet
+{
+public:
+    std::vector<glm::vec2> Position;
+    std::vector<glm::vec2> PrevPosition; // position at the start of the step, for interpolated drawing
+    std::vector<glm::vec2> Velocity;
+    float                  Radius;
+
+    BallSet(float radius = BALL_RADIUS) : Radius(radius) {}
+
+    unsigned int Count() const
+    {
+        return static_cast<unsigned int>(this->Position.size());
+    }
+    void Add(glm::vec2 position, glm::vec2 velocity)
+    {
+        this->Position.push_back(position);
+        this->PrevPosition.push_back(position);
+        this->Velocity.push_back(velocity);
+    }
+    // removes the ball in slot i by moving the last ball into it
+    void Kill(unsigned int i)
+    {
+        this->Position[i] = this->Position.back();
+        this->PrevPosition[i] = this->PrevPosition.back();
+        this->Velocity[i] = this->Velocity.back();
+        this->Position.pop_back();
+        this->PrevPosition.pop_back();
+        this->Velocity.pop_back();
+    }
+    void Clear()
+    {
+        this->Position.clear();
+        this->PrevPosition.clear();
+        this->Velocity.clear();
+    }
+};
+
+#endif
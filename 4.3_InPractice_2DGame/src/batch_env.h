@@ -0,0 +1,380 @@
+#ifndef BATCH_ENV_H
+#define BATCH_ENV_H
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "thread_pool.h"
+#include "game_constants.h"
+#include "level_data.h"
+
+// Kernels of the batched simulation. brickDistances is the hot loop (every
+// environment against every brick, every tick) and gets explicit 8 (AVX2)
+// or 4 (SSE2) wide variants like the particle kernels; the per-environment
+// loops in BatchEnv are kept branch-free so the compiler can vectorize them.
+namespace BatchKernels
+{
+    // d2[i] = squared distance from (cx, cy) to the closest point of box i, for n boxes
+    inline void brickDistancesScalar(const float *minX, const float *minY, const float *maxX, const float *maxY, float cx, float cy, float *d2, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            float dx = std::fmax(minX[i], std::fmin(cx, maxX[i])) - cx;
+            float dy = std::fmax(minY[i], std::fmin(cy, maxY[i])) - cy;
+            d2[i] = dx * dx + dy * dy;
+        }
+    }
+    inline void brickDistances(const float *minX, const float *minY, const float *maxX, const float *maxY, float cx, float cy, float *d2, std::size_t n)
+    {
+        std::size_t i = 0;
+#if defined(__AVX2__)
+        __m256 x8 = _mm256_set1_ps(cx), y8 = _mm256_set1_ps(cy);
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256 dx = _mm256_sub_ps(_mm256_max_ps(_mm256_loadu_ps(minX + i), _mm256_min_ps(x8, _mm256_loadu_ps(maxX + i))), x8);
+            __m256 dy = _mm256_sub_ps(_mm256_max_ps(_mm256_loadu_ps(minY + i), _mm256_min_ps(y8, _mm256_loadu_ps(maxY + i))), y8);
+            _mm256_storeu_ps(d2 + i, _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128 x4 = _mm_set1_ps(cx), y4 = _mm_set1_ps(cy);
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 dx = _mm_sub_ps(_mm_max_ps(_mm_loadu_ps(minX + i), _mm_min_ps(x4, _mm_loadu_ps(maxX + i))), x4);
+            __m128 dy = _mm_sub_ps(_mm_max_ps(_mm_loadu_ps(minY + i), _mm_min_ps(y4, _mm_loadu_ps(maxY + i))), y4);
+            _mm_storeu_ps(d2 + i, _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        }
+#endif
+        brickDistancesScalar(minX + i, minY + i, maxX + i, maxY + i, cx, cy, d2 + i, n - i);
+    }
+}
+
+// The bricks of a level as a structure of arrays: the geometry is shared
+// by all environments of a batch, only which bricks are left differs.
+struct BrickLayout {
+    std::vector<float>         MinX, MinY, MaxX, MaxY;
+    std::vector<unsigned char> Solid;
+
+    unsigned int Count() const
+    {
+        return static_cast<unsigned int>(this->Solid.size());
+    }
+    // reads a .lvl or .blvl file, placing the bricks exactly like GameLevel does; returns false if it can't be read
+    bool Load(const char *file, unsigned int levelWidth, unsigned int levelHeight)
+    {
+        this->MinX.clear(); this->MinY.clear(); this->MaxX.clear(); this->MaxY.clear(); this->Solid.clear();
+        LevelData tileData;
+        if (!tileData.Load(file))
+            return false;
+        unsigned int height = tileData.Height;
+        unsigned int width = tileData.Width;
+        float unit_width = levelWidth / static_cast<float>(width), unit_height = levelHeight / height;
+        for (unsigned int y = 0; y < height; ++y)
+        {
+            for (unsigned int x = 0; x < width; ++x)
+            {
+                unsigned char tile = tileData.Tile(x, y);
+                if (tile == 0)
+                    continue;
+                this->MinX.push_back(unit_width * x);
+                this->MinY.push_back(unit_height * y);
+                this->MaxX.push_back(unit_width * (x + 1));
+                this->MaxY.push_back(unit_height * (y + 1));
+                this->Solid.push_back(tile == 1);
+            }
+        }
+        return true;
+    }
+};
+
+// What the paddle of one environment does during a step
+enum BatchAction {
+    ACTION_NONE   = 0,
+    ACTION_LEFT   = 1,
+    ACTION_RIGHT  = 2,
+    ACTION_LAUNCH = 3
+};
+
+// BatchEnv runs many independent games of Breakout in lockstep, for level
+// balancing and training paddle AIs. The state of all games is kept as a
+// structure of arrays, and Step() advances every game by one tick from one
+// action per game. Environments are processed in chunks of CHUNK_SIZE
+// spread over a thread pool; within a chunk paddles and balls are moved by
+// branch-free loops over the arrays and each ball is tested against all
+// bricks of its game with BatchKernels::brickDistances.
+// The rules are GameSim's minus power-ups and screen effects, and
+// collisions are tested as overlaps at the end of each tick rather than
+// swept, which keeps the brick test a flat SIMD loop but means the batch
+// should run at SIMULATION_RATE or faster to avoid tunnelling. A game
+// starts with the ball on the paddle, a brick is worth REWARD_BRICK, a
+// lost ball REWARD_LIFE_LOST and a cleared level REWARD_CLEAR. A game that
+// is cleared, runs out of lives or reaches maxEpisodeTicks is flagged in
+// Done and restarted within the same step, so Observations always
+// describe the game that the next actions apply to. There is no
+// randomness; the same actions always produce the same results,
+// regardless of the number of threads.
+class BatchEnv
+{
+public:
+    static const unsigned int CHUNK_SIZE = 256;
+    // paddle center x, ball center x, ball center y (divided by the screen
+    // size), ball velocity x and y (divided by the initial speed), whether
+    // the ball is launched and the fraction of breakable bricks left
+    static const unsigned int OBSERVATION_SIZE = 7;
+    static const unsigned int LIVES = 3;
+    static constexpr float REWARD_BRICK = 1.0f;
+    static constexpr float REWARD_LIFE_LOST = -1.0f;
+    static constexpr float REWARD_CLEAR = 10.0f;
+
+    // game state, one entry per environment; balls and paddles are stored by their top-left corner like GameObject
+    std::vector<float>         PaddleX;
+    std::vector<float>         BallX, BallY, BallVX, BallVY;
+    std::vector<float>         Launched; // 1.0 once the ball left the paddle
+    std::vector<unsigned int>  Lives, BricksLeft;
+    std::vector<unsigned long long> EpisodeTicks;
+    // results of the last Step()
+    std::vector<float>         Rewards;
+    std::vector<unsigned char> Done;
+    std::vector<float>         Observations; // OBSERVATION_SIZE floats per environment
+
+    // threads: 0 uses one per core; maxEpisodeTicks: 0 lets a game run until it is won or lost
+    BatchEnv(unsigned int envs, const BrickLayout &layout, unsigned int width = 800, unsigned int height = 600, unsigned int threads = 0, unsigned long long maxEpisodeTicks = 0)
+        : PaddleX(envs), BallX(envs), BallY(envs), BallVX(envs), BallVY(envs), Launched(envs), Lives(envs), BricksLeft(envs), EpisodeTicks(envs),
+          Rewards(envs), Done(envs), Observations(envs * OBSERVATION_SIZE), Width(width), Height(height), MaxEpisodeTicks(maxEpisodeTicks),
+          layout(layout), envs(envs), brickCount(layout.Count()), breakable(0), pool(threads)
+    {
+        // pad the brick arrays to whole SIMD registers; padding boxes lie far off screen and are never alive
+        unsigned int padded = (this->brickCount + 7) & ~7u;
+        this->layout.MinX.resize(padded, -1.0e6f); this->layout.MaxX.resize(padded, -1.0e6f);
+        this->layout.MinY.resize(padded, -1.0e6f); this->layout.MaxY.resize(padded, -1.0e6f);
+        this->layout.Solid.resize(padded, 1);
+        this->bricks = padded;
+        this->pristine.assign(padded, 0);
+        for (unsigned int b = 0; b < this->brickCount; ++b)
+        {
+            this->pristine[b] = 1;
+            if (!this->layout.Solid[b])
+                ++this->breakable;
+        }
+        this->alive.resize(static_cast<std::size_t>(envs) * padded);
+        this->chunks = (envs + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        this->scratch.resize(static_cast<std::size_t>(this->chunks) * padded);
+        this->Reset();
+    }
+    unsigned int Size() const
+    {
+        return this->envs;
+    }
+    unsigned int BrickCount() const
+    {
+        return this->brickCount;
+    }
+    // which bricks of an environment are left, one byte per brick of the layout
+    const unsigned char *Bricks(unsigned int env) const
+    {
+        return this->alive.data() + static_cast<std::size_t>(env) * this->bricks;
+    }
+    // restarts every game
+    void Reset()
+    {
+        for (unsigned int i = 0; i < this->envs; ++i)
+        {
+            this->Reset(i);
+            this->observe(i);
+        }
+    }
+    // restarts a single game
+    void Reset(unsigned int env)
+    {
+        std::memcpy(this->alive.data() + static_cast<std::size_t>(env) * this->bricks, this->pristine.data(), this->bricks);
+        this->BricksLeft[env] = this->breakable;
+        this->Lives[env] = LIVES;
+        this->EpisodeTicks[env] = 0;
+        this->resetBall(env);
+    }
+    // advances every game by dt, actions holds one BatchAction per environment
+    void Step(const unsigned char *actions, float dt = 1.0f / SIMULATION_RATE)
+    {
+        this->pool.ParallelFor(this->chunks, [this, actions, dt](unsigned int chunk) {
+            unsigned int begin = chunk * CHUNK_SIZE;
+            unsigned int end = std::min(begin + CHUNK_SIZE, this->envs);
+            this->stepChunk(chunk, begin, end, actions, dt);
+        });
+    }
+
+    const unsigned int       Width, Height;
+    const unsigned long long MaxEpisodeTicks;
+private:
+    BrickLayout                layout;
+    unsigned int               envs, brickCount, bricks, breakable, chunks; // bricks is brickCount padded to a multiple of 8
+    std::vector<unsigned char> pristine; // brick state of a fresh game
+    std::vector<unsigned char> alive;    // envs x bricks
+    std::vector<float>         scratch;  // brick distances, one row per chunk
+    ThreadPool                 pool;
+
+    void resetBall(unsigned int env)
+    {
+        this->PaddleX[env] = this->Width / 2.0f - PLAYER_SIZE.x / 2.0f;
+        this->BallX[env] = this->PaddleX[env] + PLAYER_SIZE.x / 2.0f - BALL_RADIUS;
+        this->BallY[env] = this->Height - PLAYER_SIZE.y - BALL_RADIUS * 2.0f;
+        this->BallVX[env] = INITIAL_BALL_VELOCITY.x;
+        this->BallVY[env] = INITIAL_BALL_VELOCITY.y;
+        this->Launched[env] = 0.0f;
+    }
+    void stepChunk(unsigned int chunk, unsigned int begin, unsigned int end, const unsigned char *actions, float dt)
+    {
+        float *paddleX = this->PaddleX.data(), *ballX = this->BallX.data(), *ballY = this->BallY.data();
+        float *ballVX = this->BallVX.data(), *ballVY = this->BallVY.data(), *launched = this->Launched.data();
+        const float width = static_cast<float>(this->Width), diameter = BALL_RADIUS * 2.0f;
+        // move the paddles; a stuck ball moves along
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            float left = actions[i] == ACTION_LEFT ? 1.0f : 0.0f;
+            float right = actions[i] == ACTION_RIGHT ? 1.0f : 0.0f;
+            // same bounds checks as GameSim: only move while not yet past the edge
+            float move = PLAYER_VELOCITY * dt * (right * (paddleX[i] <= width - PLAYER_SIZE.x ? 1.0f : 0.0f) - left * (paddleX[i] >= 0.0f ? 1.0f : 0.0f));
+            paddleX[i] += move;
+            ballX[i] += move * (1.0f - launched[i]);
+            launched[i] = actions[i] == ACTION_LAUNCH ? 1.0f : launched[i];
+        }
+        // move the launched balls and bounce them off the left, right and top walls
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            float x = ballX[i] + ballVX[i] * dt * launched[i];
+            float y = ballY[i] + ballVY[i] * dt * launched[i];
+            bool wallX = x <= 0.0f || x + diameter >= width;
+            ballVX[i] = wallX ? -ballVX[i] : ballVX[i];
+            ballX[i] = std::fmin(std::fmax(x, 0.0f), width - diameter);
+            ballVY[i] = y <= 0.0f ? -ballVY[i] : ballVY[i];
+            ballY[i] = std::fmax(y, 0.0f);
+        }
+        // collisions and game rules
+        float *d2 = this->scratch.data() + static_cast<std::size_t>(chunk) * this->bricks;
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            float reward = 0.0f;
+            this->collideBricks(i, d2, reward);
+            this->collidePaddle(i);
+            bool done = false;
+            if (ballY[i] >= this->Height)
+            {
+                reward += REWARD_LIFE_LOST;
+                if (--this->Lives[i] == 0)
+                    done = true;
+                else
+                    this->resetBall(i);
+            }
+            if (this->BricksLeft[i] == 0)
+            {
+                reward += REWARD_CLEAR;
+                done = true;
+            }
+            if (++this->EpisodeTicks[i] == this->MaxEpisodeTicks)
+                done = true;
+            if (done)
+                this->Reset(i);
+            this->Rewards[i] = reward;
+            this->Done[i] = done;
+            this->observe(i);
+        }
+    }
+    void collideBricks(unsigned int env, float *d2, float &reward)
+    {
+        unsigned char *alive = this->alive.data() + static_cast<std::size_t>(env) * this->bricks;
+        const float r2 = BALL_RADIUS * BALL_RADIUS;
+        BatchKernels::brickDistances(this->layout.MinX.data(), this->layout.MinY.data(), this->layout.MaxX.data(), this->layout.MaxY.data(),
+                                     this->BallX[env] + BALL_RADIUS, this->BallY[env] + BALL_RADIUS, d2, this->bricks);
+        for (unsigned int b = 0; b < this->bricks; ++b)
+        {
+            if (!alive[b] || d2[b] >= r2)
+                continue;
+            // earlier hits of this tick may have pushed the ball away, so confirm against its current position
+            glm::vec2 difference;
+            if (!this->overlaps(env, this->layout.MinX[b], this->layout.MinY[b], this->layout.MaxX[b], this->layout.MaxY[b], difference))
+                continue;
+            if (!this->layout.Solid[b])
+            {
+                alive[b] = 0;
+                --this->BricksLeft[env];
+                reward += REWARD_BRICK;
+            }
+            this->resolve(env, difference);
+        }
+    }
+    void collidePaddle(unsigned int env)
+    {
+        glm::vec2 difference;
+        float paddleY = this->Height - PLAYER_SIZE.y;
+        if (this->Launched[env] == 0.0f || !this->overlaps(env, this->PaddleX[env], paddleY, this->PaddleX[env] + PLAYER_SIZE.x, paddleY + PLAYER_SIZE.y, difference))
+            return;
+        // same response as GameSim: the further from the center the paddle is hit, the steeper the bounce
+        float centerBoard = this->PaddleX[env] + PLAYER_SIZE.x / 2.0f;
+        float percentage = (this->BallX[env] + BALL_RADIUS - centerBoard) / (PLAYER_SIZE.x / 2.0f);
+        glm::vec2 oldVelocity(this->BallVX[env], this->BallVY[env]);
+        glm::vec2 velocity(INITIAL_BALL_VELOCITY.x * percentage * 2.0f, oldVelocity.y);
+        velocity = glm::normalize(velocity) * glm::length(oldVelocity);
+        this->BallVX[env] = velocity.x;
+        this->BallVY[env] = -std::fabs(velocity.y);
+    }
+    // circle - AABB test; difference is the vector from the ball's center to the closest point of the box
+    bool overlaps(unsigned int env, float minX, float minY, float maxX, float maxY, glm::vec2 &difference) const
+    {
+        glm::vec2 center(this->BallX[env] + BALL_RADIUS, this->BallY[env] + BALL_RADIUS);
+        glm::vec2 closest(std::fmax(minX, std::fmin(center.x, maxX)), std::fmax(minY, std::fmin(center.y, maxY)));
+        difference = closest - center;
+        return glm::dot(difference, difference) < BALL_RADIUS * BALL_RADIUS;
+    }
+    // reflects the ball off the side of the box it hit and moves it out, like GameSim::DoCollisions
+    void resolve(unsigned int env, glm::vec2 difference)
+    {
+        // the compass direction closest to the difference vector: up, right, down, left
+        float dots[4] = { difference.y, difference.x, -difference.y, -difference.x };
+        unsigned int direction = 0;
+        float max = 0.0f;
+        for (unsigned int d = 0; d < 4; ++d)
+        {
+            if (dots[d] > max)
+            {
+                max = dots[d];
+                direction = d;
+            }
+        }
+        if (direction == 1 || direction == 3) // horizontal collision
+        {
+            this->BallVX[env] = -this->BallVX[env];
+            float penetration = BALL_RADIUS - std::fabs(difference.x);
+            this->BallX[env] += direction == 3 ? penetration : -penetration;
+        }
+        else // vertical collision
+        {
+            this->BallVY[env] = -this->BallVY[env];
+            float penetration = BALL_RADIUS - std::fabs(difference.y);
+            this->BallY[env] += direction == 0 ? -penetration : penetration;
+        }
+    }
+    void observe(unsigned int env)
+    {
+        float speed = glm::length(INITIAL_BALL_VELOCITY);
+        float *o = this->Observations.data() + static_cast<std::size_t>(env) * OBSERVATION_SIZE;
+        o[0] = (this->PaddleX[env] + PLAYER_SIZE.x / 2.0f) / this->Width;
+        o[1] = (this->BallX[env] + BALL_RADIUS) / this->Width;
+        o[2] = (this->BallY[env] + BALL_RADIUS) / this->Height;
+        o[3] = this->BallVX[env] / speed;
+        o[4] = this->BallVY[env] / speed;
+        o[5] = this->Launched[env];
+        o[6] = this->breakable > 0 ? static_cast<float>(this->BricksLeft[env]) / this->breakable : 0.0f;
+    }
+};
+
+#endif
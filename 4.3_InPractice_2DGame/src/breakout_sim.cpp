@@ -0,0 +1,138 @@
+// Runs the Breakout simulation without a window, GL context or audio
+// device and reports how many fixed steps per second it manages. The
+// paddle is either driven by a script that follows the ball or by random
+// button presses; both are seeded, so a run can be replayed exactly. The
+// batch driver steps a BatchEnv of many games instead, each following the
+// ball from its observations; ticks then counts game ticks over all games.
+// The stress driver plays the scripted game while keeping the given number
+// of extra balls in play.
+//
+// usage: breakout_sim [ticks] [seed] [scripted|random|batch|stress] [games|balls]
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include "game_sim.h"
+#include "batch_env.h"
+
+// keeps the paddle under the ball and starts every game and round
+SimInput scriptedInput(const GameSim &sim)
+{
+    SimInput input;
+    // toggled every step, so the simulation sees a fresh press whenever a screen waits for one
+    input.Confirm = (sim.State != GAME_ACTIVE) && (sim.Ticks % 2 == 0);
+    input.Launch = sim.Ball.Stuck;
+    float paddle = sim.Player.Position.x + sim.Player.Size.x / 2.0f;
+    float ball = sim.Ball.Position.x + sim.Ball.Radius;
+    input.Left = ball < paddle - sim.Player.Size.x / 4.0f;
+    input.Right = ball > paddle + sim.Player.Size.x / 4.0f;
+    return input;
+}
+
+// holds a random combination of buttons for a random number of steps
+class RandomInput
+{
+public:
+    explicit RandomInput(unsigned int seed) : random(seed), hold(0) {}
+    SimInput next()
+    {
+        if (this->hold == 0)
+        {
+            unsigned int buttons = this->random();
+            this->input.Left = buttons & 1;
+            this->input.Right = (buttons >> 1) & 1;
+            this->input.Launch = (buttons >> 2) & 1;
+            this->input.Confirm = (buttons >> 3) & 1;
+            this->input.Next = (buttons >> 4) & 1;
+            this->input.Previous = (buttons >> 5) & 1;
+            this->hold = 5 + this->random() % 56;
+        }
+        --this->hold;
+        return this->input;
+    }
+private:
+    std::mt19937 random;
+    SimInput     input;
+    unsigned int hold;
+};
+
+// steps games in lockstep until ticks game ticks have been simulated
+int runBatch(unsigned long long ticks, unsigned int games)
+{
+    BrickLayout layout;
+    if (!layout.Load(FileSystem::getPath("resources/levels/one.lvl").c_str(), 800, 300))
+        return 1;
+    BatchEnv env(games, layout, 800, 600, 0, 120 * 600);
+    std::vector<unsigned char> actions(games);
+    unsigned long long steps = ticks / games, episodes = 0;
+    double reward = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long long t = 0; t < steps; ++t)
+    {
+        for (unsigned int i = 0; i < games; ++i)
+        {
+            const float *o = env.Observations.data() + i * BatchEnv::OBSERVATION_SIZE;
+            float offset = o[1] - o[0];
+            actions[i] = o[5] == 0.0f ? ACTION_LAUNCH : offset < -0.03f ? ACTION_LEFT : offset > 0.03f ? ACTION_RIGHT : ACTION_NONE;
+        }
+        env.Step(actions.data());
+        for (unsigned int i = 0; i < games; ++i)
+        {
+            episodes += env.Done[i];
+            reward += env.Rewards[i];
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << "games: " << games << ", bricks: " << env.BrickCount() << std::endl;
+    std::cout << "simulated: " << steps * games << " game ticks in " << seconds << " s (" << steps * games / seconds << " ticks/s)" << std::endl;
+    std::cout << "episodes finished: " << episodes << ", reward: " << reward << std::endl;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long long ticks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    unsigned int seed = argc > 2 ? static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10)) : 5489u;
+    const char *driver = argc > 3 ? argv[3] : "scripted";
+    bool scripted = std::strcmp(driver, "random") != 0;
+    if (std::strcmp(driver, "batch") == 0)
+    {
+        unsigned int games = argc > 4 ? std::atoi(argv[4]) : 4096;
+        std::cout << "ticks: " << ticks << ", driver: batch" << std::endl;
+        return runBatch(ticks, games);
+    }
+    unsigned int balls = 0;
+    if (std::strcmp(driver, "stress") == 0)
+        balls = argc > 4 ? std::atoi(argv[4]) : 1000;
+    std::cout << "ticks: " << ticks << ", seed: " << seed << ", driver: " << (balls ? "stress" : scripted ? "scripted" : "random") << std::endl;
+
+    GameSim sim(800, 600, seed);
+    sim.Init();
+    RandomInput randomInput(seed + 1);
+    const float dt = 1.0f / SIMULATION_RATE;
+    unsigned long long events[EVENT_LEVEL_WON + 1] = {};
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long long t = 0; t < ticks; ++t)
+    {
+        if (balls && sim.State == GAME_ACTIVE && sim.Balls.Count() < balls)
+            sim.SpawnBalls(balls - sim.Balls.Count());
+        sim.Step(scripted ? scriptedInput(sim) : randomInput.next(), dt);
+        for (const SimEvent &event : sim.Events)
+            ++events[event.Type];
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << "simulated: " << ticks / SIMULATION_RATE << " s in " << seconds << " s (" << ticks / seconds << " ticks/s, "
+              << ticks / SIMULATION_RATE / seconds << "x real time)" << std::endl;
+    const char *names[] = { "bricks destroyed", "solid hits", "power-ups collected", "paddle hits", "lives lost", "games over", "levels won" };
+    for (unsigned int i = 0; i <= EVENT_LEVEL_WON; ++i)
+        std::cout << names[i] << ": " << events[i] << std::endl;
+    return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef GAME_CONSTANTS_H
+#define GAME_CONSTANTS_H
+
+#include <glm/glm.hpp>
+
+// Gameplay tuning shared by every Breakout simulation (GameSim, BatchEnv)
+
+// Initial size of the player paddle
+const glm::vec2 PLAYER_SIZE(100.0f, 20.0f);
+// Initial velocity of the player paddle
+const float PLAYER_VELOCITY(500.0f);
+// Initial velocity of the Ball
+const glm::vec2 INITIAL_BALL_VELOCITY(100.0f, -350.0f);
+// Radius of the ball object
+const float BALL_RADIUS = 12.5f;
+// Fixed simulation steps per second, independent of the frame rate
+const float SIMULATION_RATE = 120.0f;
+
+#endif
@@ -1,56 +1,80 @@
 #ifndef GAMELEVEL_H
 #define GAMELEVEL_H
+#include <algorithm>
+#include <cmath>
+#include <string>
 #include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
 #include "game_object.h"
-#include "sprite_renderer.h"
-#include "resource_manager.h"
+#include "level_data.h"
+#include "texture_atlas.h"
+#include "render_queue.h"
 
 /// GameLevel holds all Tiles as part of a Breakout level and 
 /// hosts functionality to Load/render levels from the harddisk.
+/// Bricks carry no sprites, so levels can be loaded without a GL
+/// context; the renderer picks the sprite when drawing.
+/// Since tiles sit on a regular grid, the level also keeps the index
+/// of the brick in each grid cell, so collision tests only have to look
+/// at the cells a moving object covers (see Query()).
+/// A loaded level keeps a pristine copy of its bricks, so Reset() only
+/// copies that back instead of reading the level file again.
 
 class GameLevel
 {
 private:
+    // breakable bricks not destroyed yet
+    unsigned int remaining;
+    // the bricks as loaded, for Reset()
+    std::vector<GameObject> pristine;
+    unsigned int            pristineRemaining;
     // initialize level from tile data
-    void init(std::vector<std::vector<unsigned int>> tileData, unsigned int levelWidth, unsigned int levelHeight)
+    void init(const LevelData &tileData, unsigned int levelWidth, unsigned int levelHeight)
     {
         // calculate dimensions
-        unsigned int height = tileData.size();
-        unsigned int width = tileData[0].size(); // note we can index vector at [0] since this function is only called if height > 0
+        unsigned int height = tileData.Height;
+        unsigned int width = tileData.Width;
         float unit_width = levelWidth / static_cast<float>(width), unit_height = levelHeight / height;
+        this->Columns = width;
+        this->Rows = height;
+        this->CellSize = glm::vec2(unit_width, unit_height);
+        this->Cells.assign(width * height, -1);
         // initialize level tiles based on tileData		
         for (unsigned int y = 0; y < height; ++y)
         {
             for (unsigned int x = 0; x < width; ++x)
             {
+                unsigned int tile = tileData.Tile(x, y);
                 // check block type from level data (2D level array)
-                if (tileData[y][x] == 1) // solid
+                if (tile == 1) // solid
                 {
                     glm::vec2 pos(unit_width * x, unit_height * y);
                     glm::vec2 size(unit_width, unit_height);
-                    GameObject obj(pos, size, ResourceManager::getTexture("block_solid"), glm::vec3(0.8f, 0.8f, 0.7f));
+                    GameObject obj(pos, size, glm::vec3(0.8f, 0.8f, 0.7f));
                     obj.IsSolid = true;
+                    this->Cells[y * width + x] = static_cast<int>(this->Bricks.size());
                     this->Bricks.push_back(obj);
                 }
-                else if (tileData[y][x] > 1)	// non-solid; now determine its color based on level data
+                else if (tile > 1)	// non-solid; now determine its color based on level data
                 {
                     glm::vec3 color = glm::vec3(1.0f); // original: white
-                    if (tileData[y][x] == 2)
+                    if (tile == 2)
                         color = glm::vec3(0.2f, 0.6f, 1.0f);
-                    else if (tileData[y][x] == 3)
+                    else if (tile == 3)
                         color = glm::vec3(0.0f, 0.7f, 0.0f);
-                    else if (tileData[y][x] == 4)
+                    else if (tile == 4)
                         color = glm::vec3(0.8f, 0.8f, 0.4f);
-                    else if (tileData[y][x] == 5)
+                    else if (tile == 5)
                         color = glm::vec3(1.0f, 0.5f, 0.0f);
 
                     glm::vec2 pos(unit_width * x, unit_height * y);
                     glm::vec2 size(unit_width, unit_height);
-                    this->Bricks.push_back(GameObject(pos, size, ResourceManager::getTexture("block"), color));
+                    this->Cells[y * width + x] = static_cast<int>(this->Bricks.size());
+                    this->Bricks.push_back(GameObject(pos, size, color));
+                    ++this->remaining;
                 }
             }
         }
@@ -58,49 +82,83 @@ private:
 public:
     // level state
     std::vector<GameObject> Bricks;
+    // grid index: the brick in each cell (row-major), -1 for empty cells
+    unsigned int            Columns, Rows;
+    glm::vec2               CellSize;
+    std::vector<int>        Cells;
 
-    GameLevel(/* args */){}
+    GameLevel() : remaining(0), pristineRemaining(0), Columns(0), Rows(0), CellSize(0.0f, 0.0f) {}
     ~GameLevel(){}
 
-    // loads level from file
+    // loads level from a .lvl or compiled .blvl file
     void Load(const char *file, unsigned int levelWidth, unsigned int levelHeight)
+    {
+        LevelData tileData;
+        tileData.Load(file);
+        this->Load(tileData, levelWidth, levelHeight);
+    }
+    // builds the level from already loaded tile data
+    void Load(const LevelData &tileData, unsigned int levelWidth, unsigned int levelHeight)
     {
         // clear old data
         this->Bricks.clear();
-        // load from file
-        unsigned int tileCode;
-        GameLevel level;
-        std::string line;
-        std::ifstream fstream(file);
-        std::vector<std::vector<unsigned int>> tileData;
-        if (fstream)
+        this->Cells.clear();
+        this->Columns = this->Rows = 0;
+        this->remaining = 0;
+        if (tileData.Width > 0 && tileData.Height > 0)
+            this->init(tileData, levelWidth, levelHeight);
+        this->pristine = this->Bricks;
+        this->pristineRemaining = this->remaining;
+    }
+    // restores all bricks to how they were loaded
+    void Reset()
+    {
+        std::copy(this->pristine.begin(), this->pristine.end(), this->Bricks.begin());
+        this->remaining = this->pristineRemaining;
+    }
+    // submit the remaining bricks to a frame's render queue
+    void Draw(RenderQueue &queue, AtlasSprite &block, AtlasSprite &solid)
+    {
+        for (GameObject &tile : this->Bricks)
+            if (!tile.Destroyed)
+                tile.Draw(queue, tile.IsSolid ? solid : block, LAYER_WORLD);
+    }
+    // collects the indices of the remaining bricks in all cells overlapping the box [min, max], in Bricks order
+    void Query(glm::vec2 min, glm::vec2 max, std::vector<unsigned int> &bricks) const
+    {
+        bricks.clear();
+        if (this->Cells.empty())
+            return;
+        int x0 = static_cast<int>(std::floor(min.x / this->CellSize.x)), x1 = static_cast<int>(std::floor(max.x / this->CellSize.x));
+        int y0 = static_cast<int>(std::floor(min.y / this->CellSize.y)), y1 = static_cast<int>(std::floor(max.y / this->CellSize.y));
+        if (x1 < 0 || y1 < 0 || x0 >= static_cast<int>(this->Columns) || y0 >= static_cast<int>(this->Rows))
+            return;
+        x0 = std::max(x0, 0); x1 = std::min(x1, static_cast<int>(this->Columns) - 1);
+        y0 = std::max(y0, 0); y1 = std::min(y1, static_cast<int>(this->Rows) - 1);
+        for (int y = y0; y <= y1; ++y)
         {
-            while (std::getline(fstream, line)) // read each line from level file
+            for (int x = x0; x <= x1; ++x)
             {
-                std::istringstream sstream(line);
-                std::vector<unsigned int> row;
-                while (sstream >> tileCode) // read each word separated by spaces
-                    row.push_back(tileCode);
-                tileData.push_back(row);
+                int brick = this->Cells[y * this->Columns + x];
+                if (brick >= 0 && !this->Bricks[brick].Destroyed)
+                    bricks.push_back(static_cast<unsigned int>(brick));
             }
-            if (tileData.size() > 0)
-                this->init(tileData, levelWidth, levelHeight);
         }
     }
-    // render level
-    void Draw(SpriteRenderer &renderer)
+    // destroys a brick, keeping track of how many breakable ones are left
+    void Destroy(unsigned int brick)
     {
-        for (GameObject &tile : this->Bricks)
-            if (!tile.Destroyed)
-                tile.Draw(renderer);
+        GameObject &tile = this->Bricks[brick];
+        if (tile.Destroyed)
+            return;
+        tile.Destroyed = true;
+        if (!tile.IsSolid)
+            --this->remaining;
     }
     // check if the level is completed (all non-solid tiles are destroyed)
-    bool IsCompleted()
+    bool IsCompleted() const
     {
-        for (GameObject &tile : this->Bricks)
-            if (!tile.IsSolid && !tile.Destroyed)
-                return false;
-        return true;
+        return this->remaining == 0;
     }
 };
 
@@ -4,7 +4,10 @@
 #include <glm/glm.hpp>
 
 #include "texture.h"
+#include "texture_atlas.h"
 #include "sprite_renderer.h"
+#include "sprite_batch.h"
+#include "render_queue.h"
 
 // Container object for holding all state relevant for a single
 // game object entity. Each object in the game likely needs the
@@ -16,23 +19,52 @@ private:
 public:
     // object state
     glm::vec2   Position, Size, Velocity;
+    glm::vec2   PrevPosition; // Position before the last simulation step, drawn from when interpolating
     glm::vec3   Color;
     float       Rotation;
     bool        IsSolid;
     bool        Destroyed;
     // render state
     Texture2D   Sprite;	
+    glm::vec4   SpriteUV; // <vec2 offset, vec2 scale> of the sprite inside its (atlas) texture
     GameObject()
-         : Position(0.0f, 0.0f), Size(1.0f, 1.0f), Velocity(0.0f), Color(1.0f), Rotation(0.0f), Sprite(), IsSolid(false), Destroyed(false) 
+         : Position(0.0f, 0.0f), Size(1.0f, 1.0f), Velocity(0.0f), PrevPosition(0.0f, 0.0f), Color(1.0f), Rotation(0.0f), IsSolid(false), Destroyed(false), Sprite(), SpriteUV(0.0f, 0.0f, 1.0f, 1.0f) 
+    { }
+    // an object without a sprite of its own, as used by the simulation; see Draw(RenderQueue&, AtlasSprite&, ...)
+    GameObject(glm::vec2 pos, glm::vec2 size, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f))
+         : Position(pos), Size(size), Velocity(velocity), PrevPosition(pos), Color(color), Rotation(0.0f), IsSolid(false), Destroyed(false), Sprite(), SpriteUV(0.0f, 0.0f, 1.0f, 1.0f)
     { }
     GameObject(glm::vec2 pos, glm::vec2 size, Texture2D sprite, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f))
-         : Position(pos), Size(size), Velocity(velocity), Color(color), Rotation(0.0f), Sprite(sprite), IsSolid(false), Destroyed(false)
+         : Position(pos), Size(size), Velocity(velocity), PrevPosition(pos), Color(color), Rotation(0.0f), IsSolid(false), Destroyed(false), Sprite(sprite), SpriteUV(0.0f, 0.0f, 1.0f, 1.0f)
+    { }
+    GameObject(glm::vec2 pos, glm::vec2 size, const AtlasSprite &sprite, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f))
+         : Position(pos), Size(size), Velocity(velocity), PrevPosition(pos), Color(color), Rotation(0.0f), IsSolid(false), Destroyed(false), Sprite(sprite.Texture), SpriteUV(sprite.UV)
     { }
     ~GameObject(){}
+    // position alpha of the way from the previous simulation step to the current one
+    glm::vec2 DrawPosition(float alpha) const
+    {
+        return glm::mix(this->PrevPosition, this->Position, alpha);
+    }
     // draw sprite
     virtual void Draw(SpriteRenderer &renderer)
     {
-        renderer.DrawSprite(this->Sprite, this->Position, this->Size, this->Rotation, this->Color);
+        renderer.DrawSprite(this->Sprite, this->Position, this->Size, this->Rotation, this->Color, this->SpriteUV);
+    }
+    // queue sprite into an instanced batch
+    virtual void Draw(SpriteBatch &batch)
+    {
+        batch.DrawSprite(this->Sprite, this->Position, this->Size, this->Rotation, this->Color, this->SpriteUV);
+    }
+    // submit sprite to a frame's render queue, interpolated between the last two simulation steps
+    virtual void Draw(RenderQueue &queue, unsigned int layer = LAYER_WORLD, float alpha = 1.0f)
+    {
+        queue.DrawSprite(layer, this->Sprite, this->DrawPosition(alpha), this->Size, this->Rotation, this->Color, this->SpriteUV);
+    }
+    // submit the object drawn with a sprite picked by the caller
+    void Draw(RenderQueue &queue, AtlasSprite &sprite, unsigned int layer = LAYER_WORLD, float alpha = 1.0f)
+    {
+        queue.DrawSprite(layer, sprite, this->DrawPosition(alpha), this->Size, this->Rotation, this->Color);
     }
 };
 
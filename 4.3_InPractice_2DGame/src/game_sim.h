@@ -0,0 +1,645 @@
+#ifndef GAME_SIM_H
+#define GAME_SIM_H
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "filesystem.h"
+#include "profiler.h"
+#include "thread_pool.h"
+
+#include "game_constants.h"
+#include "game_level.h"
+#include "power_up.h"
+#include "ball_object.h"
+#include "ball_set.h"
+
+// Represents the current state of the game
+enum GameState {
+    GAME_ACTIVE,
+    GAME_MENU,
+    GAME_WIN
+};
+
+// The buttons held during one simulation step. Presses are detected by
+// the simulation itself, comparing against the previous step's input.
+struct SimInput {
+    bool Left, Right;     // move the paddle
+    bool Launch;          // release the ball from the paddle
+    bool Confirm;         // start a game / leave the win screen
+    bool Next, Previous;  // pick a level in the menu
+
+    SimInput() : Left(false), Right(false), Launch(false), Confirm(false), Next(false), Previous(false) {}
+};
+
+// Something that happened during a step that a presentation layer (sound,
+// particles) or a test harness may react to
+enum SimEventType {
+    EVENT_BRICK_DESTROYED,
+    EVENT_SOLID_HIT,
+    EVENT_POWERUP_COLLECTED,
+    EVENT_PADDLE_HIT,
+    EVENT_LIFE_LOST,
+    EVENT_GAME_OVER,
+    EVENT_LEVEL_WON
+};
+struct SimEvent {
+    SimEventType Type;
+    glm::vec2    Position; // center of the object involved
+    glm::vec3    Color;
+};
+
+// GameSim holds the complete game state of Breakout (levels, paddle, balls,
+// power-ups, lives) and advances it in fixed steps. It has no window, GL
+// context or audio device, so it can be stepped headless, e.g. by the
+// breakout_sim benchmark; Game drives one and draws it. Randomness comes
+// from the simulation's own generator, so a seed and an input sequence
+// always replay the same game.
+class GameSim
+{
+public:
+    // most straight segments the ball is moved in per step; any distance left after that many bounces is dropped
+    static const unsigned int MAX_BOUNCES = 8;
+    // extra balls handed to one thread at a time
+    static const unsigned int BALL_CHUNK = 256;
+    // extra balls released by the multi-ball power-up
+    static const unsigned int MULTIBALL_BALLS = 2;
+    // game state
+    GameState               State;
+    unsigned int            Width, Height;
+    std::vector<GameLevel>  Levels;
+    std::vector<PowerUp>    PowerUps;
+    unsigned int            Level;
+    unsigned int            Lives;
+    GameObject              Player;
+    BallObject              Ball;
+    // extra balls of multi-ball play; the player only loses a life once the last ball is gone
+    BallSet                 Balls;
+    // threads moving the extra balls, 0 uses one per core
+    unsigned int            Threads;
+    // screen effects requested by power-ups and solid bricks; the renderer mirrors them
+    bool                    Confuse, Chaos, Shake;
+    float                   ShakeTime;
+    // what happened during the last Step()
+    std::vector<SimEvent>   Events;
+    unsigned long long      Ticks;
+
+    GameSim(unsigned int width, unsigned int height, unsigned int seed = 5489u)
+        : State(GAME_MENU), Width(width), Height(height), Level(0), Lives(3), Threads(0), Confuse(false), Chaos(false), Shake(false), ShakeTime(0.0f), Ticks(0), random(seed) {}
+    // loads the levels and puts paddle and ball in their starting positions
+    void Init()
+    {
+        const char *files[] = { "resources/levels/one", "resources/levels/two", "resources/levels/three", "resources/levels/four" };
+        this->Levels.clear();
+        for (const char *file : files)
+        {
+            GameLevel level;
+            level.Load(levelPath(file).c_str(), this->Width, this->Height / 2);
+            this->Levels.push_back(level);
+        }
+        this->Level = 0;
+        glm::vec2 playerPos = glm::vec2(this->Width / 2.0f - PLAYER_SIZE.x / 2.0f, this->Height - PLAYER_SIZE.y);
+        this->Player = GameObject(playerPos, PLAYER_SIZE);
+        glm::vec2 ballPos = playerPos + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, -BALL_RADIUS * 2.0f);
+        this->Ball = BallObject(ballPos, BALL_RADIUS, INITIAL_BALL_VELOCITY);
+    }
+    // advances the game by dt seconds with the given buttons held
+    void Step(const SimInput &input, float dt)
+    {
+        this->Events.clear();
+        // remember where the moving objects were so they can be drawn interpolated
+        this->Player.PrevPosition = this->Player.Position;
+        this->Ball.PrevPosition = this->Ball.Position;
+        this->Balls.PrevPosition = this->Balls.Position;
+        for (PowerUp &powerUp : this->PowerUps)
+            powerUp.PrevPosition = powerUp.Position;
+        this->ProcessInput(input, dt);
+        this->Update(dt);
+        this->previous = input;
+        ++this->Ticks;
+    }
+    void ProcessInput(const SimInput &input, float dt)
+    {
+        PROFILE_SCOPE("GameSim::ProcessInput");
+        if (this->State == GAME_MENU)
+        {
+            if (input.Confirm && !this->previous.Confirm)
+                this->State = GAME_ACTIVE;
+            if (input.Next && !this->previous.Next)
+                this->Level = (this->Level + 1) % this->Levels.size();
+            if (input.Previous && !this->previous.Previous)
+                this->Level = this->Level > 0 ? this->Level - 1 : static_cast<unsigned int>(this->Levels.size() - 1);
+        }
+        if (this->State == GAME_WIN)
+        {
+            if (input.Confirm && !this->previous.Confirm)
+            {
+                this->Chaos = false;
+                this->State = GAME_MENU;
+            }
+        }
+        if (this->State == GAME_ACTIVE)
+        {
+            float velocity = PLAYER_VELOCITY * dt;
+            // move playerboard
+            if (input.Left)
+            {
+                if (this->Player.Position.x >= 0.0f)
+                {
+                    this->Player.Position.x -= velocity;
+                    if (this->Ball.Stuck)
+                        this->Ball.Position.x -= velocity;
+                }
+            }
+            if (input.Right)
+            {
+                if (this->Player.Position.x <= this->Width - this->Player.Size.x)
+                {
+                    this->Player.Position.x += velocity;
+                    if (this->Ball.Stuck)
+                        this->Ball.Position.x += velocity;
+                }
+            }
+            if (input.Launch)
+                this->Ball.Stuck = false;
+        }
+    }
+    void Update(float dt)
+    {
+        PROFILE_SCOPE("GameSim::Update");
+        // update objects; the ball bounces off everything it touches on its way
+        this->MoveBall(dt);
+        this->MoveBalls(dt);
+        // check for collisions
+        this->DoCollisions();
+        // update PowerUps
+        this->UpdatePowerUps(dt);
+        // reduce shake time
+        if (this->ShakeTime > 0.0f)
+        {
+            this->ShakeTime -= dt;
+            if (this->ShakeTime <= 0.0f)
+                this->Shake = false;
+        }
+        // check loss condition
+        if (this->Ball.Position.y >= this->Height && this->Balls.Count() > 0)
+        {
+            // another ball is still in play and takes over as the player's ball
+            unsigned int last = this->Balls.Count() - 1;
+            this->Ball.Position = this->Balls.Position[last];
+            this->Ball.PrevPosition = this->Balls.PrevPosition[last];
+            this->Ball.Velocity = this->Balls.Velocity[last];
+            this->Balls.Kill(last);
+        }
+        if (this->Ball.Position.y >= this->Height) // did ball reach bottom edge?
+        {
+            --this->Lives;
+            this->emit(EVENT_LIFE_LOST, this->Ball);
+            // did the player lose all his lives? : game over
+            if (this->Lives == 0)
+            {
+                this->emit(EVENT_GAME_OVER, this->Ball);
+                this->ResetLevel();
+                this->State = GAME_MENU;
+            }
+            this->ResetPlayer();
+        }
+        // check win condition
+        if (this->State == GAME_ACTIVE && this->Levels[this->Level].IsCompleted())
+        {
+            this->emit(EVENT_LEVEL_WON, this->Ball);
+            this->ResetLevel();
+            this->ResetPlayer();
+            this->Chaos = true;
+            this->State = GAME_WIN;
+        }
+    }
+    // moves the ball by its velocity over dt, in as many straight segments
+    // as it has bounces: each segment ends at the earliest point where the
+    // ball touches a wall, brick or the paddle, so it can't tunnel through
+    // anything no matter how fast it is or how long the step
+    void MoveBall(float dt)
+    {
+        PROFILE_SCOPE("GameSim::MoveBall");
+        float remaining = 1.0f; // fraction of dt still to travel
+        for (unsigned int bounce = 0; bounce < MAX_BOUNCES && remaining > 0.0f && !this->Ball.Stuck; ++bounce)
+        {
+            glm::vec2 motion = this->Ball.Velocity * dt * remaining;
+            BallHit hit = this->FindHit(this->Ball.Position, this->Ball.Radius, motion, this->candidates);
+            if (hit.Type == HIT_NONE)
+            {
+                this->Ball.Position += motion;
+                break;
+            }
+            this->Ball.Position += motion * hit.Time;
+            remaining *= 1.0f - hit.Time;
+            if (hit.Type == HIT_PADDLE)
+            {
+                this->Ball.Velocity = this->PaddleBounce(this->Ball.Position, this->Ball.Radius, this->Ball.Velocity);
+                // if Sticky powerup is activated, also stick ball to paddle once new velocity vectors were calculated
+                this->Ball.Stuck = this->Ball.Sticky;
+                this->emit(EVENT_PADDLE_HIT, this->Ball);
+            }
+            else if (hit.Type == HIT_WALL || this->HitBrick(hit.Brick))
+                this->Ball.Bounce(hit.Normal);
+        }
+    }
+    // moves the extra balls like MoveBall, all of them at once. Every round
+    // each ball looks for its next hit in parallel; then the brick hits are
+    // applied in order of (time of impact, ball index), so of several balls
+    // reaching the same brick the first one breaks it and the others carry
+    // on as if it had never been there; finally all balls move up to their
+    // hits in parallel. The outcome doesn't depend on the number of threads.
+    void MoveBalls(float dt)
+    {
+        PROFILE_SCOPE("GameSim::MoveBalls");
+        unsigned int count = this->Balls.Count();
+        if (count == 0)
+            return;
+        GameLevel &level = this->Levels[this->Level];
+        unsigned int chunks = (count + BALL_CHUNK - 1) / BALL_CHUNK;
+        this->ballRemaining.assign(count, 1.0f);
+        this->ballHits.resize(count);
+        if (this->ballCandidates.size() < chunks)
+            this->ballCandidates.resize(chunks);
+        for (unsigned int round = 0; round < MAX_BOUNCES; ++round)
+        {
+            // find the next hit of every ball that still has some way to go; nothing is modified yet
+            this->forEachBallChunk(chunks, [this, dt, count](unsigned int chunk) {
+                unsigned int end = std::min((chunk + 1) * BALL_CHUNK, count);
+                for (unsigned int i = chunk * BALL_CHUNK; i < end; ++i)
+                    if (this->ballRemaining[i] > 0.0f)
+                        this->ballHits[i] = this->FindHit(this->Balls.Position[i], this->Balls.Radius, this->Balls.Velocity[i] * dt * this->ballRemaining[i], this->ballCandidates[chunk]);
+            });
+            // break bricks in a fixed order
+            this->brickHits.clear();
+            for (unsigned int i = 0; i < count; ++i)
+                if (this->ballRemaining[i] > 0.0f && this->ballHits[i].Type == HIT_BRICK)
+                    this->brickHits.push_back(i);
+            std::sort(this->brickHits.begin(), this->brickHits.end(), [this](unsigned int a, unsigned int b) {
+                return this->ballHits[a].Time < this->ballHits[b].Time || (this->ballHits[a].Time == this->ballHits[b].Time && a < b);
+            });
+            for (unsigned int i : this->brickHits)
+            {
+                BallHit &hit = this->ballHits[i];
+                if (level.Bricks[hit.Brick].Destroyed)
+                    hit.Type = HIT_RETRY;
+                else if (!this->HitBrick(hit.Brick))
+                    hit.Type = HIT_PASS;
+            }
+            // move and bounce; every ball only touches its own state
+            this->forEachBallChunk(chunks, [this, dt, count](unsigned int chunk) {
+                unsigned int end = std::min((chunk + 1) * BALL_CHUNK, count);
+                for (unsigned int i = chunk * BALL_CHUNK; i < end; ++i)
+                {
+                    float &remaining = this->ballRemaining[i];
+                    const BallHit &hit = this->ballHits[i];
+                    if (remaining <= 0.0f || hit.Type == HIT_RETRY)
+                        continue;
+                    glm::vec2 motion = this->Balls.Velocity[i] * dt * remaining;
+                    if (hit.Type == HIT_NONE)
+                    {
+                        this->Balls.Position[i] += motion;
+                        remaining = 0.0f;
+                        continue;
+                    }
+                    this->Balls.Position[i] += motion * hit.Time;
+                    remaining *= 1.0f - hit.Time;
+                    if (hit.Type == HIT_PADDLE)
+                        this->Balls.Velocity[i] = this->PaddleBounce(this->Balls.Position[i], this->Balls.Radius, this->Balls.Velocity[i]);
+                    else if (hit.Type != HIT_PASS)
+                        this->Balls.Velocity[i] = BallObject::Reflect(this->Balls.Velocity[i], hit.Normal);
+                }
+            });
+            if (std::find_if(this->ballRemaining.begin(), this->ballRemaining.end(), [](float remaining) { return remaining > 0.0f; }) == this->ballRemaining.end())
+                break;
+        }
+        // balls that left through the bottom are gone
+        for (unsigned int i = this->Balls.Count(); i-- > 0;)
+            if (this->Balls.Position[i].y >= this->Height)
+                this->Balls.Kill(i);
+    }
+    // adds extra balls at the player's ball, fanned out upwards over 120 degrees at its speed
+    void SpawnBalls(unsigned int count)
+    {
+        float speed = glm::length(this->Ball.Velocity);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            float angle = glm::radians(-60.0f + 120.0f * (i + 0.5f) / count);
+            this->Balls.Add(this->Ball.Position, glm::vec2(std::sin(angle), -std::cos(angle)) * speed);
+        }
+    }
+    void DoCollisions()
+    {
+        PROFILE_SCOPE("GameSim::DoCollisions");
+        // check collisions on PowerUps and if so, activate them
+        for (PowerUp &powerUp : this->PowerUps)
+        {
+            if (!powerUp.Destroyed)
+            {
+                // first check if powerup passed bottom edge, if so: keep as inactive and destroy
+                if (powerUp.Position.y >= this->Height)
+                    powerUp.Destroyed = true;
+
+                if (CheckCollision(this->Player, powerUp))
+                {	// collided with player, now activate powerup
+                    this->ActivatePowerUp(powerUp);
+                    powerUp.Destroyed = true;
+                    powerUp.Activated = true;
+                    this->emit(EVENT_POWERUP_COLLECTED, powerUp);
+                }
+            }
+        }
+    }
+    // the compiled .blvl version of a level (built by the levels target) if it is at least as new as the .lvl, the .lvl otherwise
+    static std::string levelPath(const std::string &file)
+    {
+        std::string source = FileSystem::getPath(file + ".lvl"), compiled = FileSystem::getPath(file + ".blvl");
+        std::error_code error;
+        std::filesystem::file_time_type compiledTime = std::filesystem::last_write_time(compiled, error);
+        if (error)
+            return source;
+        std::filesystem::file_time_type sourceTime = std::filesystem::last_write_time(source, error);
+        if (!error && sourceTime > compiledTime)
+        {
+            std::cout << "GAMESIM: " << compiled << " is older than its source, loading " << source << std::endl;
+            return source;
+        }
+        return compiled;
+    }
+    // reset
+    void ResetLevel()
+    {
+        this->Levels[this->Level].Reset();
+        this->Lives = 3;
+    }
+    void ResetPlayer()
+    {
+        // reset player/ball stats
+        this->Player.Size = PLAYER_SIZE;
+        this->Player.Position = this->Player.PrevPosition = glm::vec2(this->Width / 2.0f - PLAYER_SIZE.x / 2.0f, this->Height - PLAYER_SIZE.y);
+        this->Ball.Reset(this->Player.Position + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, -(BALL_RADIUS * 2.0f)), INITIAL_BALL_VELOCITY);
+        this->Balls.Clear();
+        // also disable all active powerups
+        this->Chaos = this->Confuse = false;
+        this->Ball.PassThrough = this->Ball.Sticky = false;
+        this->Player.Color = glm::vec3(1.0f);
+        this->Ball.Color = glm::vec3(1.0f);
+    }
+    // powerups
+    void SpawnPowerUps(GameObject &block)
+    {
+        if (this->ShouldSpawn(75)) // 1 in 75 chance
+            this->PowerUps.push_back(PowerUp("speed", glm::vec3(0.5f, 0.5f, 1.0f), 0.0f, block.Position));
+        if (this->ShouldSpawn(75))
+            this->PowerUps.push_back(PowerUp("sticky", glm::vec3(1.0f, 0.5f, 1.0f), 20.0f, block.Position));
+        if (this->ShouldSpawn(75))
+            this->PowerUps.push_back(PowerUp("pass-through", glm::vec3(0.5f, 1.0f, 0.5f), 10.0f, block.Position));
+        if (this->ShouldSpawn(75))
+            this->PowerUps.push_back(PowerUp("pad-size-increase", glm::vec3(1.0f, 0.6f, 0.4), 0.0f, block.Position));
+        if (this->ShouldSpawn(75))
+            this->PowerUps.push_back(PowerUp("multi-ball", glm::vec3(0.4f, 0.8f, 1.0f), 0.0f, block.Position));
+        if (this->ShouldSpawn(15)) // Negative powerups should spawn more often
+            this->PowerUps.push_back(PowerUp("confuse", glm::vec3(1.0f, 0.3f, 0.3f), 15.0f, block.Position));
+        if (this->ShouldSpawn(15))
+            this->PowerUps.push_back(PowerUp("chaos", glm::vec3(0.9f, 0.25f, 0.25f), 15.0f, block.Position));
+    }
+    void ActivatePowerUp(PowerUp &powerUp)
+    {
+        if (powerUp.Type == "speed")
+        {
+            this->Ball.Velocity *= 1.2;
+        }
+        else if (powerUp.Type == "sticky")
+        {
+            this->Ball.Sticky = true;
+            this->Player.Color = glm::vec3(1.0f, 0.5f, 1.0f);
+        }
+        else if (powerUp.Type == "pass-through")
+        {
+            this->Ball.PassThrough = true;
+            this->Ball.Color = glm::vec3(1.0f, 0.5f, 0.5f);
+        }
+        else if (powerUp.Type == "pad-size-increase")
+        {
+            this->Player.Size.x += 50;
+        }
+        else if (powerUp.Type == "multi-ball")
+        {
+            this->SpawnBalls(MULTIBALL_BALLS);
+        }
+        else if (powerUp.Type == "confuse")
+        {
+            if (!this->Chaos)
+                this->Confuse = true; // only activate if chaos wasn't already active
+        }
+        else if (powerUp.Type == "chaos")
+        {
+            if (!this->Confuse)
+                this->Chaos = true;
+        }
+    }
+    void UpdatePowerUps(float dt)
+    {
+        for (PowerUp &powerUp : this->PowerUps)
+        {
+            powerUp.Position += powerUp.Velocity * dt;
+            if (powerUp.Activated)
+            {
+                powerUp.Duration -= dt;
+
+                if (powerUp.Duration <= 0.0f)
+                {
+                    // remove powerup from list (will later be removed)
+                    powerUp.Activated = false;
+                    // deactivate effects
+                    if (powerUp.Type == "sticky")
+                    {
+                        if (!this->IsOtherPowerUpActive("sticky"))
+                        {	// only reset if no other PowerUp of type sticky is active
+                            this->Ball.Sticky = false;
+                            this->Player.Color = glm::vec3(1.0f);
+                        }
+                    }
+                    else if (powerUp.Type == "pass-through")
+                    {
+                        if (!this->IsOtherPowerUpActive("pass-through"))
+                        {	// only reset if no other PowerUp of type pass-through is active
+                            this->Ball.PassThrough = false;
+                            this->Ball.Color = glm::vec3(1.0f);
+                        }
+                    }
+                    else if (powerUp.Type == "confuse")
+                    {
+                        if (!this->IsOtherPowerUpActive("confuse"))
+                        {	// only reset if no other PowerUp of type confuse is active
+                            this->Confuse = false;
+                        }
+                    }
+                    else if (powerUp.Type == "chaos")
+                    {
+                        if (!this->IsOtherPowerUpActive("chaos"))
+                        {	// only reset if no other PowerUp of type chaos is active
+                            this->Chaos = false;
+                        }
+                    }
+                }
+            }
+        }
+        // Remove all PowerUps from vector that are destroyed AND !activated (thus either off the map or finished)
+        // Note we use a lambda expression to remove each PowerUp which is destroyed and not activated
+        this->PowerUps.erase(std::remove_if(this->PowerUps.begin(), this->PowerUps.end(),
+            [](const PowerUp &powerUp) { return powerUp.Destroyed && !powerUp.Activated; }
+        ), this->PowerUps.end());
+    }
+private:
+    // the first thing a ball runs into along a segment
+    enum BallHitType {
+        HIT_NONE,
+        HIT_WALL,
+        HIT_BRICK,
+        HIT_PADDLE,
+        HIT_PASS,  // went through a breakable brick it broke
+        HIT_RETRY  // the brick was broken by another ball first
+    };
+    struct BallHit {
+        BallHitType  Type;
+        float        Time;   // fraction of the segment
+        glm::vec2    Normal;
+        unsigned int Brick;
+    };
+    std::mt19937 random;
+    // input of the previous step, to detect presses
+    SimInput     previous;
+    // bricks near the ball, reused every step
+    std::vector<unsigned int> candidates;
+    // multi-ball scratch: per ball, per chunk of balls, and the balls that hit a brick this round
+    std::vector<float>        ballRemaining;
+    std::vector<BallHit>      ballHits;
+    std::vector<std::vector<unsigned int>> ballCandidates;
+    std::vector<unsigned int> brickHits;
+    std::unique_ptr<ThreadPool> workers; // created when there are enough balls to share out
+
+    // earliest wall, brick or paddle contact of a ball at position moving by motion; walls go first so bricks and paddle win ties
+    BallHit FindHit(glm::vec2 position, float radius, glm::vec2 motion, std::vector<unsigned int> &bricks) const
+    {
+        BallHit hit = { HIT_NONE, 2.0f, glm::vec2(0.0f, 0.0f), 0 };
+        float t;
+        glm::vec2 n;
+        if (BallObject::SweepWalls(position, radius, motion, static_cast<float>(this->Width), t, n))
+        {
+            hit.Type = HIT_WALL; hit.Time = t; hit.Normal = n;
+        }
+        // only bricks in the grid cells the segment covers can be hit
+        const GameLevel &level = this->Levels[this->Level];
+        glm::vec2 end = position + motion;
+        level.Query(glm::min(position, end), glm::max(position, end) + radius * 2.0f, bricks);
+        for (unsigned int index : bricks)
+        {
+            const GameObject &box = level.Bricks[index];
+            if (BallObject::Sweep(position, radius, motion, box.Position, box.Position + box.Size, t, n) && t < hit.Time)
+            {
+                hit.Type = HIT_BRICK; hit.Time = t; hit.Normal = n; hit.Brick = index;
+            }
+        }
+        if (BallObject::Sweep(position, radius, motion, this->Player.Position, this->Player.Position + this->Player.Size, t, n) && t < hit.Time)
+        {
+            hit.Type = HIT_PADDLE; hit.Time = t; hit.Normal = n;
+        }
+        return hit;
+    }
+    // breaks a brick or shakes the screen for a solid one; returns whether the ball bounces off it
+    bool HitBrick(unsigned int brick)
+    {
+        GameLevel &level = this->Levels[this->Level];
+        GameObject &box = level.Bricks[brick];
+        // destroy block if not solid
+        if (!box.IsSolid)
+        {
+            level.Destroy(brick);
+            this->SpawnPowerUps(box);
+            this->emit(EVENT_BRICK_DESTROYED, box);
+        }
+        else
+        {
+            // if block is solid, enable shake effect
+            this->ShakeTime = 0.05f;
+            this->Shake = true;
+            this->emit(EVENT_SOLID_HIT, box);
+        }
+        // a pass-through ball keeps going through non-solid bricks
+        return !(this->Ball.PassThrough && !box.IsSolid);
+    }
+    // the velocity of a ball at position after bouncing off the paddle
+    glm::vec2 PaddleBounce(glm::vec2 position, float radius, glm::vec2 velocity) const
+    {
+        // check where it hit the board, and change velocity based on where it hit the board
+        float centerBoard = this->Player.Position.x + this->Player.Size.x / 2.0f;
+        float distance = (position.x + radius) - centerBoard;
+        float percentage = distance / (this->Player.Size.x / 2.0f);
+        // then move accordingly
+        float strength = 2.0f;
+        glm::vec2 oldVelocity = velocity;
+        velocity.x = INITIAL_BALL_VELOCITY.x * percentage * strength;
+        velocity = glm::normalize(velocity) * glm::length(oldVelocity); // keep speed consistent over both axes (multiply by length of old velocity, so total strength is not changed)
+        // fix sticky paddle
+        velocity.y = -1.0f * std::abs(velocity.y);
+        return velocity;
+    }
+    // runs work for every chunk of extra balls, on the worker threads if there is more than one chunk
+    void forEachBallChunk(unsigned int chunks, const std::function<void(unsigned int)> &work)
+    {
+        if (chunks == 1)
+        {
+            work(0);
+            return;
+        }
+        if (!this->workers)
+            this->workers.reset(new ThreadPool(this->Threads));
+        this->workers->ParallelFor(chunks, work);
+    }
+
+    void emit(SimEventType type, const GameObject &object)
+    {
+        SimEvent event = { type, object.Position + object.Size * 0.5f, object.Color };
+        this->Events.push_back(event);
+    }
+    bool ShouldSpawn(unsigned int chance)
+    {
+        return this->random() % chance == 0;
+    }
+    bool IsOtherPowerUpActive(const std::string &type) const
+    {
+        // Check if another PowerUp of the same type is still active
+        // in which case we don't disable its effect (yet)
+        for (const PowerUp &powerUp : this->PowerUps)
+        {
+            if (powerUp.Activated)
+                if (powerUp.Type == type)
+                    return true;
+        }
+        return false;
+    }
+    // collision detection
+    static bool CheckCollision(const GameObject &one, const GameObject &two) // AABB - AABB collision
+    {
+        // collision x-axis?
+        bool collisionX = one.Position.x + one.Size.x >= two.Position.x &&
+            two.Position.x + two.Size.x >= one.Position.x;
+        // collision y-axis?
+        bool collisionY = one.Position.y + one.Size.y >= two.Position.y &&
+            two.Position.y + two.Size.y >= one.Position.y;
+        // collision only if on both axes
+        return collisionX && collisionY;
+    }
+};
+
+#endif
@@ -0,0 +1,34 @@
+// Compiles .lvl text levels into the binary .blvl format GameSim prefers
+// when loading (see level_data.h). Each level is written next to its
+// source with the extension replaced, then read back to check it.
+//
+// usage: level_compiler <file.lvl>...
+#include <iostream>
+#include <string>
+
+#include "level_data.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: level_compiler <file.lvl>..." << std::endl;
+        return 1;
+    }
+    int failed = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string source = argv[i];
+        std::string::size_type dot = source.find_last_of('.');
+        std::string target = (dot == std::string::npos ? source : source.substr(0, dot)) + ".blvl";
+        LevelData level, check;
+        if (!level.LoadText(source) || !level.SaveBinary(target) || !check.LoadBinary(target) || check.Tiles != level.Tiles)
+        {
+            std::cout << "ERROR::LEVEL_COMPILER: Failed to compile " << source << std::endl;
+            ++failed;
+            continue;
+        }
+        std::cout << source << " -> " << target << " (" << level.Width << "x" << level.Height << ")" << std::endl;
+    }
+    return failed ? 1 : 0;
+}
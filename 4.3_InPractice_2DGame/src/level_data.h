@@ -0,0 +1,182 @@
+#ifndef LEVEL_DATA_H
+#define LEVEL_DATA_H
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LEVEL_DATA_MMAP
+#endif
+
+// LevelData holds the tile codes of a level as a flat row-major byte
+// array: 0 is empty, 1 a solid brick and 2-5 breakable bricks of
+// different colors (see GameLevel).
+//
+// Levels are written by hand as .lvl text files, one row of space
+// separated codes per line, and can be compiled into .blvl files that
+// load without any parsing:
+//
+//     offset  size    content
+//     0       4       magic "BLVL"
+//     4       4       format version (BLVL_VERSION)
+//     8       4       width in tiles
+//     12      4       height in tiles
+//     16      w * h   tile codes, row-major
+//
+// Header fields are little-endian uint32s.
+const char          BLVL_MAGIC[4] = { 'B', 'L', 'V', 'L' };
+const std::uint32_t BLVL_VERSION = 1;
+const unsigned int  BLVL_HEADER_SIZE = 16;
+
+class LevelData
+{
+public:
+    unsigned int               Width, Height;
+    std::vector<unsigned char> Tiles;
+
+    LevelData() : Width(0), Height(0) {}
+
+    unsigned char Tile(unsigned int x, unsigned int y) const
+    {
+        return this->Tiles[y * this->Width + x];
+    }
+    // loads a level file, compiled or text depending on its extension; returns false if it can't be read
+    bool Load(const std::string &file)
+    {
+        bool compiled = file.size() >= 5 && file.compare(file.size() - 5, 5, ".blvl") == 0;
+        return compiled ? this->LoadBinary(file) : this->LoadText(file);
+    }
+    // parses a .lvl text file; the level is as wide as its longest row, shorter rows are padded with empty tiles
+    bool LoadText(const std::string &file)
+    {
+        this->Width = this->Height = 0;
+        this->Tiles.clear();
+        std::ifstream fstream(file);
+        std::string line;
+        std::vector<std::vector<unsigned char>> rows;
+        while (std::getline(fstream, line))
+        {
+            std::vector<unsigned char> row;
+            const char *c = line.c_str();
+            while (*c)
+            {
+                char *end;
+                unsigned long code = std::strtoul(c, &end, 10);
+                if (end == c)
+                {
+                    ++c;
+                    continue;
+                }
+                row.push_back(static_cast<unsigned char>(code));
+                c = end;
+            }
+            this->Width = std::max(this->Width, static_cast<unsigned int>(row.size()));
+            rows.push_back(row);
+        }
+        if (this->Width == 0)
+        {
+            std::cout << "ERROR::LEVEL: Failed to read level file " << file << std::endl;
+            return false;
+        }
+        this->Height = static_cast<unsigned int>(rows.size());
+        this->Tiles.assign(this->Width * this->Height, 0);
+        for (unsigned int y = 0; y < this->Height; ++y)
+            std::copy(rows[y].begin(), rows[y].end(), this->Tiles.begin() + y * this->Width);
+        return true;
+    }
+    // reads a compiled .blvl file, mapping it into memory where the platform allows
+    bool LoadBinary(const std::string &file)
+    {
+        this->Width = this->Height = 0;
+        this->Tiles.clear();
+#ifdef LEVEL_DATA_MMAP
+        int fd = open(file.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0)
+        {
+            if (fd >= 0)
+                close(fd);
+            std::cout << "ERROR::LEVEL: Failed to open level file " << file << std::endl;
+            return false;
+        }
+        size_t size = static_cast<size_t>(info.st_size);
+        void *data = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (data == MAP_FAILED)
+        {
+            std::cout << "ERROR::LEVEL: Failed to map level file " << file << std::endl;
+            return false;
+        }
+        bool ok = this->parseBinary(static_cast<const unsigned char *>(data), size, file);
+        munmap(data, size);
+        return ok;
+#else
+        std::ifstream fstream(file, std::ios::binary);
+        if (!fstream)
+        {
+            std::cout << "ERROR::LEVEL: Failed to open level file " << file << std::endl;
+            return false;
+        }
+        std::vector<unsigned char> data((std::istreambuf_iterator<char>(fstream)), std::istreambuf_iterator<char>());
+        return this->parseBinary(data.data(), data.size(), file);
+#endif
+    }
+    // writes the level as a compiled .blvl file
+    bool SaveBinary(const std::string &file) const
+    {
+        unsigned char header[BLVL_HEADER_SIZE];
+        std::memcpy(header, BLVL_MAGIC, 4);
+        writeUint32(header + 4, BLVL_VERSION);
+        writeUint32(header + 8, this->Width);
+        writeUint32(header + 12, this->Height);
+        std::ofstream fstream(file, std::ios::binary);
+        fstream.write(reinterpret_cast<const char *>(header), BLVL_HEADER_SIZE);
+        fstream.write(reinterpret_cast<const char *>(this->Tiles.data()), this->Tiles.size());
+        if (!fstream)
+        {
+            std::cout << "ERROR::LEVEL: Failed to write level file " << file << std::endl;
+            return false;
+        }
+        return true;
+    }
+private:
+    bool parseBinary(const unsigned char *data, size_t size, const std::string &file)
+    {
+        if (size < BLVL_HEADER_SIZE || std::memcmp(data, BLVL_MAGIC, 4) != 0 || readUint32(data + 4) != BLVL_VERSION)
+        {
+            std::cout << "ERROR::LEVEL: Not a compiled level (version " << BLVL_VERSION << "): " << file << std::endl;
+            return false;
+        }
+        std::uint32_t width = readUint32(data + 8), height = readUint32(data + 12);
+        if (width == 0 || height == 0 || (size - BLVL_HEADER_SIZE) / width < height)
+        {
+            std::cout << "ERROR::LEVEL: Truncated level file " << file << std::endl;
+            return false;
+        }
+        this->Width = width;
+        this->Height = height;
+        this->Tiles.assign(data + BLVL_HEADER_SIZE, data + BLVL_HEADER_SIZE + static_cast<size_t>(width) * height);
+        return true;
+    }
+    static std::uint32_t readUint32(const unsigned char *p)
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+    }
+    static void writeUint32(unsigned char *p, std::uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            p[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+};
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef PARTICLE_POOL_H
+#define PARTICLE_POOL_H
+#include <cstddef>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include <glm/glm.hpp>
+
+// Integration kernels working on the raw float streams of a ParticlePool.
+// The SIMD variants process 8 (AVX2) or 4 (SSE2) floats per iteration and
+// finish the remainder with the scalar loop; the scalar variant is always
+// available as a fallback and as a reference for benchmarking.
+namespace ParticleKernels
+{
+    // v[i] -= d[i] * dt for n floats
+    inline void subtractScaledScalar(float *v, const float *d, float dt, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            v[i] -= d[i] * dt;
+    }
+    // v[i] -= k for n floats
+    inline void subtractScalar(float *v, float k, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            v[i] -= k;
+    }
+    // alpha channel of n rgba colors -= k
+    inline void fadeScalar(float *rgba, float k, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            rgba[i * 4 + 3] -= k;
+    }
+
+    inline void subtractScaled(float *v, const float *d, float dt, std::size_t n)
+    {
+        std::size_t i = 0;
+#if defined(__AVX2__)
+        __m256 t8 = _mm256_set1_ps(dt);
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(v + i, _mm256_sub_ps(_mm256_loadu_ps(v + i), _mm256_mul_ps(_mm256_loadu_ps(d + i), t8)));
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128 t4 = _mm_set1_ps(dt);
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(v + i, _mm_sub_ps(_mm_loadu_ps(v + i), _mm_mul_ps(_mm_loadu_ps(d + i), t4)));
+#endif
+        subtractScaledScalar(v + i, d + i, dt, n - i);
+    }
+    inline void subtract(float *v, float k, std::size_t n)
+    {
+        std::size_t i = 0;
+#if defined(__AVX2__)
+        __m256 k8 = _mm256_set1_ps(k);
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(v + i, _mm256_sub_ps(_mm256_loadu_ps(v + i), k8));
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128 k4 = _mm_set1_ps(k);
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(v + i, _mm_sub_ps(_mm_loadu_ps(v + i), k4));
+#endif
+        subtractScalar(v + i, k, n - i);
+    }
+    inline void fade(float *rgba, float k, std::size_t n)
+    {
+        std::size_t i = 0;
+#if defined(__AVX2__)
+        // two colors per register, only the alpha lanes are touched
+        __m256 k8 = _mm256_setr_ps(0.0f, 0.0f, 0.0f, k, 0.0f, 0.0f, 0.0f, k);
+        for (; i + 2 <= n; i += 2)
+            _mm256_storeu_ps(rgba + i * 4, _mm256_sub_ps(_mm256_loadu_ps(rgba + i * 4), k8));
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128 k4 = _mm_setr_ps(0.0f, 0.0f, 0.0f, k);
+        for (; i < n; ++i)
+            _mm_storeu_ps(rgba + i * 4, _mm_sub_ps(_mm_loadu_ps(rgba + i * 4), k4));
+#endif
+        fadeScalar(rgba + i * 4, k, n - i);
+    }
+}
+
+// ParticlePool stores particles as a structure of arrays: positions,
+// velocities, colors and remaining life each live in their own tightly
+// packed array. Live particles always occupy the first Count slots, so
+// updating and rendering never touches dead particles; spawning appends
+// and killing swaps the last live particle into the freed slot, both O(1).
+class ParticlePool
+{
+public:
+    std::vector<glm::vec2> Position;
+    std::vector<glm::vec2> Velocity;
+    std::vector<glm::vec4> Color;
+    std::vector<float>     Life;
+    // number of live particles, stored in [0, Count)
+    unsigned int Count;
+
+    ParticlePool(unsigned int capacity)
+        : Position(capacity), Velocity(capacity), Color(capacity), Life(capacity, 0.0f), Count(0), recycle(0) {}
+
+    unsigned int Capacity() const
+    {
+        return static_cast<unsigned int>(this->Life.size());
+    }
+    // returns the slot of a new particle; when the pool is full an existing
+    // particle is recycled in round-robin order instead
+    unsigned int Spawn()
+    {
+        if (this->Count < this->Capacity())
+            return this->Count++;
+        this->recycle = (this->recycle + 1) % this->Capacity();
+        return this->recycle;
+    }
+    // removes the particle in slot i by moving the last live particle into it
+    void Kill(unsigned int i)
+    {
+        unsigned int last = --this->Count;
+        if (i != last)
+        {
+            this->Position[i] = this->Position[last];
+            this->Velocity[i] = this->Velocity[last];
+            this->Color[i] = this->Color[last];
+            this->Life[i] = this->Life[last];
+        }
+    }
+    // advances all live particles by dt, fading their alpha by fadeRate per second, and removes the ones that died
+    void Update(float dt, float fadeRate, bool simd = true)
+    {
+        if (this->Count == 0)
+            return;
+        float *life = this->Life.data();
+        float *position = reinterpret_cast<float*>(this->Position.data());
+        const float *velocity = reinterpret_cast<const float*>(this->Velocity.data());
+        float *color = reinterpret_cast<float*>(this->Color.data());
+        if (simd)
+        {
+            ParticleKernels::subtract(life, dt, this->Count);
+            ParticleKernels::subtractScaled(position, velocity, dt, this->Count * 2);
+            ParticleKernels::fade(color, dt * fadeRate, this->Count);
+        }
+        else
+        {
+            ParticleKernels::subtractScalar(life, dt, this->Count);
+            ParticleKernels::subtractScaledScalar(position, velocity, dt, this->Count * 2);
+            ParticleKernels::fadeScalar(color, dt * fadeRate, this->Count);
+        }
+        // walk backwards so every particle swapped into a freed slot has already been checked
+        for (unsigned int i = this->Count; i-- > 0;)
+            if (this->Life[i] <= 0.0f)
+                this->Kill(i);
+    }
+    // kills all particles
+    void Clear()
+    {
+        this->Count = 0;
+        this->recycle = 0;
+    }
+private:
+    // slot that is overwritten next when the pool is full
+    unsigned int recycle;
+};
+
+#endif
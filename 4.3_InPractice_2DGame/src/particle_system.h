@@ -0,0 +1,263 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "texture.h"
+#include "particle_pool.h"
+
+// A single source of particles (ball trail, brick shatter, ...). Every
+// emitter owns its own particle storage; the ParticleSystem decides how
+// many particles it may keep.
+class ParticleEmitter
+{
+public:
+    ParticlePool Particles;
+    Texture2D    Texture;
+    // emitters with a higher priority keep their particles when the budget is exceeded
+    int          Priority;
+    // alpha lost per second
+    float        FadeRate;
+
+    ParticleEmitter(Texture2D texture, unsigned int capacity, int priority, float fadeRate)
+        : Particles(capacity), Texture(texture), Priority(priority), FadeRate(fadeRate) {}
+};
+
+// ParticleSystem owns any number of emitters that share one global
+// particle budget. When spawning would exceed the budget, particles of
+// emitters with an equal or lower priority are culled first, picking the
+// oldest and the ones furthest away from Focus. Emitters are updated one
+// after the other with the SIMD kernels of ParticlePool; a budget of a few
+// thousand particles is far too little work to be worth waking threads for.
+// They are rendered with one instanced draw per texture.
+class ParticleSystem
+{
+public:
+    // maximum number of live particles over all emitters
+    unsigned int Budget;
+    // point of interest used for distance based culling (e.g. the ball)
+    glm::vec2    Focus;
+    // distance at which a particle counts as much as one second of remaining life
+    float        CullDistance;
+
+    ParticleSystem(Shader shader, unsigned int budget)
+        : Budget(budget), Focus(0.0f), CullDistance(400.0f), shader(shader)
+    {
+        this->init();
+    }
+    // adds an emitter and returns its handle
+    unsigned int AddEmitter(Texture2D texture, unsigned int capacity, int priority, float fadeRate = 2.5f)
+    {
+        this->emitters.push_back(std::unique_ptr<ParticleEmitter>(new ParticleEmitter(texture, capacity, priority, fadeRate)));
+        return static_cast<unsigned int>(this->emitters.size() - 1);
+    }
+    ParticleEmitter &GetEmitter(unsigned int emitter)
+    {
+        return *this->emitters[emitter];
+    }
+    // spawns a single particle; returns false if the budget didn't allow it
+    bool Emit(unsigned int emitter, glm::vec2 position, glm::vec2 velocity, glm::vec4 color, float life = 1.0f)
+    {
+        if (this->Reserve(emitter, 1) == 0)
+            return false;
+        this->spawn(*this->emitters[emitter], position, velocity, color, life);
+        return true;
+    }
+    // spawns up to count particles flying outwards from position in random directions; returns the number spawned
+    unsigned int Burst(unsigned int emitter, unsigned int count, glm::vec2 position, float speed, glm::vec3 color, float life = 1.0f)
+    {
+        count = this->Reserve(emitter, count);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            float angle = (rand() % 628) / 100.0f;
+            float magnitude = speed * (0.5f + (rand() % 100) / 200.0f);
+            float shade = 0.75f + (rand() % 50) / 100.0f;
+            glm::vec2 velocity(std::cos(angle) * magnitude, std::sin(angle) * magnitude);
+            this->spawn(*this->emitters[emitter], position, velocity, glm::vec4(color * shade, 1.0f), life);
+        }
+        return count;
+    }
+    // makes room for count new particles of the given emitter by culling lower priority particles; returns how many may be spawned
+    unsigned int Reserve(unsigned int emitter, unsigned int count)
+    {
+        unsigned int live = this->LiveCount();
+        if (live + count <= this->Budget)
+            return count;
+        unsigned int excess = live + count - this->Budget;
+        int priority = this->emitters[emitter]->Priority;
+        // visit candidate emitters from the lowest priority up
+        std::vector<ParticleEmitter*> victims;
+        for (auto &e : this->emitters)
+            if (e->Priority <= priority && e->Particles.Count > 0)
+                victims.push_back(e.get());
+        std::stable_sort(victims.begin(), victims.end(), [](const ParticleEmitter *a, const ParticleEmitter *b) {
+            return a->Priority < b->Priority;
+        });
+        for (ParticleEmitter *victim : victims)
+        {
+            if (excess == 0)
+                break;
+            excess -= this->cull(*victim, excess);
+        }
+        return count - std::min(count, excess);
+    }
+    // advances all emitters
+    void Update(float dt)
+    {
+        for (auto &emitter : this->emitters)
+            emitter->Particles.Update(dt, emitter->FadeRate);
+    }
+    // renders all live particles; emitters sharing a texture are drawn with one instanced call.
+    // Particles are meant to be drawn with additive blending, which the caller sets (see RenderQueue).
+    // A lag > 0 draws them where they were that many seconds before the last Update(), which
+    // interpolates them between two fixed simulation steps
+    void Draw(float lag = 0.0f)
+    {
+        // order emitters by texture and stream their particles back to back
+        std::vector<ParticleEmitter*> order;
+        for (auto &e : this->emitters)
+            if (e->Particles.Count > 0)
+                order.push_back(e.get());
+        if (order.empty())
+            return;
+        std::stable_sort(order.begin(), order.end(), [](const ParticleEmitter *a, const ParticleEmitter *b) {
+            return a->Texture.ID < b->Texture.ID;
+        });
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, this->capacity * (sizeof(glm::vec2) + sizeof(glm::vec4)), NULL, GL_STREAM_DRAW);
+        unsigned int total = 0;
+        for (ParticleEmitter *emitter : order)
+        {
+            unsigned int count = std::min(emitter->Particles.Count, this->capacity - total);
+            const glm::vec2 *positions = emitter->Particles.Position.data();
+            if (lag > 0.0f)
+            {
+                // particles integrate as position -= velocity * dt, so stepping back adds velocity * lag
+                this->lagged.assign(positions, positions + count);
+                ParticleKernels::subtractScaled(reinterpret_cast<float*>(this->lagged.data()), reinterpret_cast<const float*>(emitter->Particles.Velocity.data()), -lag, count * 2);
+                positions = this->lagged.data();
+            }
+            glBufferSubData(GL_ARRAY_BUFFER, total * sizeof(glm::vec2), count * sizeof(glm::vec2), positions);
+            glBufferSubData(GL_ARRAY_BUFFER, this->capacity * sizeof(glm::vec2) + total * sizeof(glm::vec4), count * sizeof(glm::vec4), emitter->Particles.Color.data());
+            total += count;
+        }
+        this->shader.use();
+        GLState::get().activeTexture(GL_TEXTURE0);
+        GLState::get().bindVertexArray(this->VAO);
+        unsigned int first = 0;
+        for (unsigned int i = 0; i < order.size();)
+        {
+            // gather the run of emitters sharing this texture
+            unsigned int count = 0;
+            unsigned int j = i;
+            for (; j < order.size() && order[j]->Texture.ID == order[i]->Texture.ID; ++j)
+                count += order[j]->Particles.Count;
+            count = std::min(count, total - first);
+            // point the instance attributes at the start of the run
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)(first * sizeof(glm::vec2)));
+            glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)(this->capacity * sizeof(glm::vec2) + first * sizeof(glm::vec4)));
+            order[i]->Texture.bind();
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(count));
+            first += count;
+            i = j;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    // number of live particles over all emitters
+    unsigned int LiveCount() const
+    {
+        unsigned int live = 0;
+        for (auto &e : this->emitters)
+            live += e->Particles.Count;
+        return live;
+    }
+    // kills all particles
+    void Clear()
+    {
+        for (auto &e : this->emitters)
+            e->Particles.Clear();
+    }
+private:
+    // render state
+    Shader shader;
+    unsigned int VAO, instanceVBO;
+    // size of the instance buffer, in particles
+    unsigned int capacity;
+    // state
+    std::vector<std::unique_ptr<ParticleEmitter>> emitters;
+    // scratch positions of Draw() with a lag
+    std::vector<glm::vec2> lagged;
+
+    // initializes buffer and vertex attributes
+    void init()
+    {
+        // the budget can be raised at runtime, so leave some headroom in the instance buffer
+        this->capacity = this->Budget * 2;
+        unsigned int VBO;
+        float particle_quad[] = {
+            0.0f, 1.0f, 0.0f, 1.0f,
+            1.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 0.0f,
+
+            0.0f, 1.0f, 0.0f, 1.0f,
+            1.0f, 1.0f, 1.0f, 1.0f,
+            1.0f, 0.0f, 1.0f, 0.0f
+        };
+        glGenVertexArrays(1, &this->VAO);
+        glGenBuffers(1, &VBO);
+        GLState::get().bindVertexArray(this->VAO);
+        // fill mesh buffer
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(particle_quad), particle_quad, GL_STATIC_DRAW);
+        // set mesh attributes
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        // set per-instance attributes; the buffer holds all offsets followed by all colors
+        glGenBuffers(1, &this->instanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, this->capacity * (sizeof(glm::vec2) + sizeof(glm::vec4)), NULL, GL_STREAM_DRAW);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)(this->capacity * sizeof(glm::vec2)));
+        glVertexAttribDivisor(2, 1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        GLState::get().bindVertexArray(0);
+    }
+    void spawn(ParticleEmitter &emitter, glm::vec2 position, glm::vec2 velocity, glm::vec4 color, float life)
+    {
+        unsigned int i = emitter.Particles.Spawn();
+        emitter.Particles.Position[i] = position;
+        emitter.Particles.Velocity[i] = velocity;
+        emitter.Particles.Color[i] = color;
+        emitter.Particles.Life[i] = life;
+    }
+    // kills up to count particles of the emitter, least important first; returns the number killed
+    unsigned int cull(ParticleEmitter &emitter, unsigned int count)
+    {
+        ParticlePool &pool = emitter.Particles;
+        count = std::min(count, pool.Count);
+        // importance: remaining life, minus a penalty for being far away from the focus
+        std::vector<std::pair<float, unsigned int>> scores(pool.Count);
+        for (unsigned int i = 0; i < pool.Count; ++i)
+            scores[i] = std::make_pair(pool.Life[i] - glm::length(pool.Position[i] - this->Focus) / this->CullDistance, i);
+        std::nth_element(scores.begin(), scores.begin() + count, scores.end());
+        // kill in descending slot order so swap-remove never moves a particle that is still to be killed
+        std::vector<unsigned int> slots;
+        for (unsigned int i = 0; i < count; ++i)
+            slots.push_back(scores[i].second);
+        std::sort(slots.rbegin(), slots.rend());
+        for (unsigned int slot : slots)
+            pool.Kill(slot);
+        return count;
+    }
+};
+
+#endif
@@ -1,116 +1,220 @@
 #ifndef POST_PROCESSOR_H
 #define POST_PROCESSOR_H
 
+#include <vector>
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "profiler.h"
+#include "resource_manager.h"
 #include "texture.h"
 #include "sprite_renderer.h"
 #include "shader.h"
 
+// One pass of the post-processing chain: a program that reads the output
+// of the previous pass from the 'scene' sampler
+struct PostEffect {
+    Shader      Program;
+    bool        Enabled;
+    const char *Name; // shown by the profiler, which keeps the pointer: use a string literal
+
+    PostEffect(Shader program, const char *name, bool enabled = false) : Program(program), Enabled(enabled), Name(name) {}
+};
+
 // PostProcessor hosts all PostProcessing effects for the Breakout
 // Game. It renders the game on a textured quad after which one can
-// enable specific effects by enabling either the Confuse, Chaos or 
-// Shake boolean. 
+// enable specific effects by enabling either the Confuse, Chaos or
+// Shake boolean.
 // It is required to call BeginRender() before rendering the game
 // and EndRender() after rendering the game for the class to work.
+// Effects form an ordered chain of passes, each with its own program;
+// enabled passes read the previous result from one of two ping-pong
+// textures and the last one renders to the screen. The built-in effects
+// are the first three passes; chaos overrides confuse, as it always has.
+// The shake pass has a variant of its own for when it is the last pass
+// and may move the quad. Disabled passes cost nothing.
+// With MSAA every frame is drawn into the multisampled buffer, so
+// antialiasing doesn't change when effects toggle; while no effect is
+// enabled it is resolved straight to the screen and no pass runs. Without
+// MSAA such frames are drawn into the default framebuffer directly. The
+// choice is made once per frame in BeginRender().
 class PostProcessor
 {
 public:
     // state
-    Shader PostProcessingShader;
     Texture2D Texture;
     unsigned int Width, Height;
-    // options
+    // MSAA samples of the offscreen color buffer; 0 renders into the texture directly
+    unsigned int Samples;
+    // options; these switch the built-in chaos, confuse and shake passes
     bool Confuse, Chaos, Shake;
     // constructor
-    PostProcessor(Shader shader, unsigned int width, unsigned int height)
-        : PostProcessingShader(shader), Texture(), Width(width), Height(height), Confuse(false), Chaos(false), Shake(false)
+    PostProcessor(unsigned int width, unsigned int height, unsigned int samples = 4)
+        : Texture(), Width(width), Height(height), Samples(samples), Confuse(false), Chaos(false), Shake(false), MSFBO(0), RBO(0), active(false)
     {
         // initialize renderbuffer/framebuffer object
-        glGenFramebuffers(1, &this->MSFBO);
         glGenFramebuffers(1, &this->FBO);
-        glGenRenderbuffers(1, &this->RBO);
-        // initialize renderbuffer storage with a multisampled color buffer (don't need a depth/stencil buffer)
-        glBindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
-        glBindRenderbuffer(GL_RENDERBUFFER, this->RBO);
-        glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_RGB, width, height); // allocate storage for render buffer object
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->RBO); // attach MS render buffer object to framebuffer
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "ERROR::POSTPROCESSOR: Failed to initialize MSFBO" << std::endl;
+        if (this->Samples > 0)
+        {
+            glGenFramebuffers(1, &this->MSFBO);
+            glGenRenderbuffers(1, &this->RBO);
+            // initialize renderbuffer storage with a multisampled color buffer (don't need a depth/stencil buffer)
+            GLState::get().bindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
+            glBindRenderbuffer(GL_RENDERBUFFER, this->RBO);
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, this->Samples, GL_RGB, width, height); // allocate storage for render buffer object
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->RBO); // attach MS render buffer object to framebuffer
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "ERROR::POSTPROCESSOR: Failed to initialize MSFBO" << std::endl;
+        }
         // also initialize the FBO/texture to blit multisampled color-buffer to; used for shader operations (for postprocessing effects)
-        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
-        this->Texture.generate(width, height, NULL);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->Texture.ID, 0); // attach texture to framebuffer as its color attachment
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "ERROR::POSTPROCESSOR: Failed to initialize FBO" << std::endl;
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        // initialize render data and uniforms
+        this->initTarget(this->FBO, this->Texture, "FBO");
+        // the ping-pong targets are only created once two passes are enabled at the same time
+        this->pingPongFBO[0] = this->pingPongFBO[1] = 0;
+        // initialize render data and the built-in effects, in the order they are applied
         this->initRenderData();
-        this->PostProcessingShader.setInt("scene", 0, true);
-        float offset = 1.0f / 300.0f;
-        float offsets[9][2] = {
-            { -offset,  offset  },  // top-left
-            {  0.0f,    offset  },  // top-center
-            {  offset,  offset  },  // top-right
-            { -offset,  0.0f    },  // center-left
-            {  0.0f,    0.0f    },  // center-center
-            {  offset,  0.0f    },  // center - right
-            { -offset, -offset  },  // bottom-left
-            {  0.0f,   -offset  },  // bottom-center
-            {  offset, -offset  }   // bottom-right    
-        };
-        glUniform2fv(glGetUniformLocation(this->PostProcessingShader.ID, "offsets"), 9, (float*)offsets);
-        int edge_kernel[9] = {
-            -1, -1, -1,
-            -1,  8, -1,
-            -1, -1, -1
-        };
-        glUniform1iv(glGetUniformLocation(this->PostProcessingShader.ID, "edge_kernel"), 9, edge_kernel);
-        float blur_kernel[9] = {
-            1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f,
-            2.0f / 16.0f, 4.0f / 16.0f, 2.0f / 16.0f,
-            1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f
-        };
-        glUniform1fv(glGetUniformLocation(this->PostProcessingShader.ID, "blur_kernel"), 9, blur_kernel);    
+        this->chaosPass = this->AddEffect(this->loadEffect("shaders/post_chaos.vs", "shaders/post_chaos.fs", "post_chaos"), "PostProcessor::Chaos");
+        this->confusePass = this->AddEffect(this->loadEffect("shaders/post_processing.vs", "shaders/post_confuse.fs", "post_confuse"), "PostProcessor::Confuse");
+        // the intermediate variant shakes the coordinates, the LAST one the quad
+        this->shakeLastBit = ResourceManager::loadShader(FileSystem::getPath("shaders/post_shake.vs").c_str(), FileSystem::getPath("shaders/post_shake.fs").c_str(), nullptr, "post_shake", { "LAST" }).key("LAST");
+        this->shakePass = this->AddEffect(ResourceManager::getShader("post_shake", 0), "PostProcessor::Shake");
+    }
+    // appends a pass to the end of the chain; returns its index. Every pass needs a name of its own
+    // (a string literal), otherwise the profiler reports passes sharing a name as one
+    unsigned int AddEffect(Shader program, const char *name, bool enabled = false)
+    {
+        program.setInt("scene", 0, true);
+        this->effects.push_back(PostEffect(program, name, enabled));
+        return static_cast<unsigned int>(this->effects.size() - 1);
+    }
+    PostEffect &GetEffect(unsigned int index)
+    {
+        return this->effects[index];
+    }
+    // true if any effect is enabled, i.e. the frame has to go through the offscreen pass
+    bool Active() const
+    {
+        if (this->Confuse || this->Chaos || this->Shake)
+            return true;
+        for (const PostEffect &effect : this->effects)
+            if (effect.Enabled)
+                return true;
+        return false;
     }
     // prepares the postprocessor's framebuffer operations before rendering the game
     void BeginRender()
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
+        PROFILE_SCOPE("PostProcessor::BeginRender");
+        PROFILE_GPU_SCOPE("PostProcessor::BeginRender");
+        // latch the path for the whole frame so toggling an effect mid-frame can't split it
+        this->effects[this->chaosPass].Enabled = this->Chaos;
+        this->effects[this->confusePass].Enabled = this->Confuse && !this->Chaos;
+        this->effects[this->shakePass].Enabled = this->Shake;
+        this->active = this->Active();
+        if (this->Samples > 0)
+            GLState::get().bindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
+        else
+            GLState::get().bindFramebuffer(GL_FRAMEBUFFER, this->active ? this->FBO : 0);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
     }
     // should be called after rendering the game, so it stores all the rendered data into a texture object
     void EndRender()
     {
-        // now resolve multisampled color-buffer into intermediate FBO to store to texture
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, this->MSFBO);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->FBO);
+        if (!this->active && this->Samples == 0)
+            return;
+        PROFILE_GPU_SCOPE("PostProcessor::Resolve");
+        if (this->Samples == 0)
+        {
+            GLState::get().bindFramebuffer(GL_FRAMEBUFFER, 0);
+            return;
+        }
+        // now resolve multisampled color-buffer into intermediate FBO to store to texture, or right onto the screen if no effect reads it
+        GLState::get().bindFramebuffer(GL_READ_FRAMEBUFFER, this->MSFBO);
+        GLState::get().bindFramebuffer(GL_DRAW_FRAMEBUFFER, this->active ? this->FBO : 0);
         glBlitFramebuffer(0, 0, this->Width, this->Height, 0, 0, this->Width, this->Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0); // binds both READ and WRITE framebuffer to default framebuffer
+        GLState::get().bindFramebuffer(GL_FRAMEBUFFER, 0); // binds both READ and WRITE framebuffer to default framebuffer
     }
-    // renders the PostProcessor texture quad (as a screen-encompassing large sprite)
-    void Render(float time)
+    // runs the enabled passes, the last one rendering a screen-encompassing quad to the default framebuffer
+    void Render()
     {
-        // set uniforms/options
-        this->PostProcessingShader.use();
-        this->PostProcessingShader.setFloat("time", time);
-        this->PostProcessingShader.setInt("confuse", this->Confuse);
-        this->PostProcessingShader.setInt("chaos", this->Chaos);
-        this->PostProcessingShader.setInt("shake", this->Shake);
-        // render textured quad
-        glActiveTexture(GL_TEXTURE0);
-        this->Texture.bind();	
-        glBindVertexArray(this->VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
+        // the game was already rendered to the screen
+        if (!this->active)
+            return;
+        PROFILE_SCOPE("PostProcessor::Render");
+        PROFILE_GPU_SCOPE("PostProcessor::Render");
+        unsigned int last = 0;
+        for (unsigned int i = 0; i < this->effects.size(); ++i)
+            if (this->effects[i].Enabled)
+                last = i;
+        unsigned int source = this->Texture.ID;
+        unsigned int target = 0;
+        GLState::get().activeTexture(GL_TEXTURE0);
+        GLState::get().bindVertexArray(this->VAO);
+        for (unsigned int i = 0; i <= last; ++i)
+        {
+            if (!this->effects[i].Enabled)
+                continue;
+            PROFILE_GPU_SCOPE(this->effects[i].Name);
+            if (i != last)
+                this->initPingPong();
+            GLState::get().bindFramebuffer(GL_FRAMEBUFFER, i == last ? 0 : this->pingPongFBO[target]);
+            Shader program = this->effects[i].Program;
+            if (i == this->shakePass && i == last)
+            {
+                // compiled the first time the shake ends the chain
+                program = ResourceManager::getShader("post_shake", this->shakeLastBit);
+                program.setInt("scene", 0, true);
+            }
+            program.use();
+            GLState::get().bindTexture(source);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            if (i != last)
+            {
+                source = this->pingPongTexture[target].ID;
+                target ^= 1;
+            }
+        }
     }
 private:
     // render state
     unsigned int MSFBO, FBO; // MSFBO = Multisampled FBO. FBO is regular, used for blitting MS color-buffer to texture
     unsigned int RBO; // RBO is used for multisampled color buffer
     unsigned int VAO;
+    // intermediate targets of the effect chain
+    unsigned int pingPongFBO[2];
+    Texture2D    pingPongTexture[2];
+    // effect chain
+    std::vector<PostEffect> effects;
+    unsigned int chaosPass, confusePass, shakePass;
+    unsigned int shakeLastBit; // variant key of the shake pass drawing to the screen
+    // whether the current frame goes through the offscreen pass
+    bool active;
+    // creates the ping-pong targets passes render into when they are not the last one
+    void initPingPong()
+    {
+        if (this->pingPongFBO[0] != 0)
+            return;
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            glGenFramebuffers(1, &this->pingPongFBO[i]);
+            this->initTarget(this->pingPongFBO[i], this->pingPongTexture[i], "ping-pong FBO");
+        }
+    }
+    static Shader loadEffect(const char *vShaderFile, const char *fShaderFile, std::string name)
+    {
+        return ResourceManager::loadShader(FileSystem::getPath(vShaderFile).c_str(), FileSystem::getPath(fShaderFile).c_str(), nullptr, name);
+    }
+    // creates a texture of the screen's size and attaches it to the framebuffer
+    void initTarget(unsigned int fbo, Texture2D &texture, const char *name)
+    {
+        GLState::get().bindFramebuffer(GL_FRAMEBUFFER, fbo);
+        texture.generate(this->Width, this->Height, NULL);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.ID, 0); // attach texture to framebuffer as its color attachment
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::POSTPROCESSOR: Failed to initialize " << name << std::endl;
+        GLState::get().bindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
     // initialize quad for rendering postprocessing texture
     void initRenderData()
     {
@@ -132,12 +236,12 @@ private:
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-        glBindVertexArray(this->VAO);
+        GLState::get().bindVertexArray(this->VAO);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        GLState::get().bindVertexArray(0);
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -25,8 +25,10 @@ public:
     std::string Type;
     float       Duration;	
     bool        Activated;
-    PowerUp(std::string type, glm::vec3 color, float duration, glm::vec2 position, Texture2D texture)
-        : GameObject(position, POWERUP_SIZE, texture, color, VELOCITY), Type(type), Duration(duration), Activated() {}
+    PowerUp(std::string type, glm::vec3 color, float duration, glm::vec2 position)
+        : GameObject(position, POWERUP_SIZE, color, VELOCITY), Type(type), Duration(duration), Activated() {}
+    PowerUp(std::string type, glm::vec3 color, float duration, glm::vec2 position, const AtlasSprite &sprite)
+        : GameObject(position, POWERUP_SIZE, sprite, color, VELOCITY), Type(type), Duration(duration), Activated() {}
     ~PowerUp(){}
 };
 
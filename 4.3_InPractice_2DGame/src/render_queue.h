@@ -0,0 +1,143 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "texture.h"
+#include "texture_atlas.h"
+#include "sprite_batch.h"
+
+// Layers are drawn back to front; everything in a higher layer covers the lower ones
+enum RenderLayer {
+    LAYER_BACKGROUND = 0,
+    LAYER_WORLD      = 1,
+    LAYER_PARTICLES  = 2,
+    LAYER_FOREGROUND = 3
+};
+// Blend function a command is drawn with
+enum BlendMode {
+    BLEND_ALPHA    = 0, // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+    BLEND_ADDITIVE = 1  // GL_SRC_ALPHA, GL_ONE
+};
+
+// A single draw submitted to the RenderQueue: either a sprite that ends
+// up in the SpriteBatch or a callback doing its own rendering
+struct RenderCommand {
+    uint64_t       Key;
+    unsigned int   Texture;
+    SpriteInstance Sprite;
+    int            Callback; // index into the queue's callbacks, -1 for sprites
+};
+
+// RenderQueue collects the draws of a frame and executes them sorted by a
+// 64-bit key, from most to least significant:
+//   layer (8 bits) | blend mode (2) | shader (12) | texture (16) | sequence (26)
+// so within a layer, draws sharing blend state, program and texture run
+// back to back no matter in which order they were submitted; the
+// sequence number keeps submission order among otherwise equal draws.
+// Sprites are funneled into one SpriteBatch and blend state is only
+// touched when it actually changes.
+class RenderQueue
+{
+public:
+    // statistics of the last Execute()
+    unsigned int Commands, BlendChanges;
+
+    RenderQueue(SpriteBatch &batch, unsigned int spriteShader)
+        : Commands(0), BlendChanges(0), batch(batch), spriteShader(spriteShader), sequence(0) {}
+
+    static uint64_t MakeKey(unsigned int layer, BlendMode blend, unsigned int shader, unsigned int texture, unsigned int sequence)
+    {
+        return (static_cast<uint64_t>(layer & 0xFF) << 56)
+             | (static_cast<uint64_t>(blend & 0x3) << 54)
+             | (static_cast<uint64_t>(shader & 0xFFF) << 42)
+             | (static_cast<uint64_t>(texture & 0xFFFF) << 26)
+             | static_cast<uint64_t>(sequence & 0x3FFFFFF);
+    }
+    // queues a textured quad drawn by the sprite batch
+    void DrawSprite(unsigned int layer, Texture2D &texture, glm::vec2 position, glm::vec2 size, float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f), glm::vec4 uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), BlendMode blend = BLEND_ALPHA)
+    {
+        RenderCommand command;
+        command.Key = MakeKey(layer, blend, this->spriteShader, texture.ID, this->sequence++);
+        command.Texture = texture.ID;
+        command.Sprite.Position = position;
+        command.Sprite.Size = size;
+        command.Sprite.Color = color;
+        command.Sprite.Rotation = glm::radians(rotate);
+        command.Sprite.UV = uv;
+        command.Callback = -1;
+        this->commands.push_back(command);
+    }
+    void DrawSprite(unsigned int layer, AtlasSprite &sprite, glm::vec2 position, glm::vec2 size, float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f), BlendMode blend = BLEND_ALPHA)
+    {
+        this->DrawSprite(layer, sprite.Texture, position, size, rotate, color, sprite.UV, blend);
+    }
+    // queues a callback that renders with its own shader and texture; the queue sets the blend mode beforehand
+    void Submit(unsigned int layer, BlendMode blend, unsigned int shader, unsigned int texture, std::function<void()> draw)
+    {
+        RenderCommand command;
+        command.Key = MakeKey(layer, blend, shader, texture, this->sequence++);
+        command.Texture = texture;
+        command.Callback = static_cast<int>(this->callbacks.size());
+        this->callbacks.push_back(std::move(draw));
+        this->commands.push_back(command);
+    }
+    // sorts and renders everything submitted since the last call
+    void Execute()
+    {
+        std::sort(this->commands.begin(), this->commands.end(), [](const RenderCommand &a, const RenderCommand &b) {
+            return a.Key < b.Key;
+        });
+        this->Commands = static_cast<unsigned int>(this->commands.size());
+        this->BlendChanges = 0;
+        BlendMode blend = BLEND_ALPHA;
+        this->batch.Begin();
+        for (const RenderCommand &command : this->commands)
+        {
+            BlendMode commandBlend = static_cast<BlendMode>((command.Key >> 54) & 0x3);
+            if (commandBlend != blend)
+            {
+                // sprites queued so far were meant for the previous blend mode
+                this->batch.Flush();
+                setBlend(commandBlend);
+                blend = commandBlend;
+                ++this->BlendChanges;
+            }
+            if (command.Callback < 0)
+                this->batch.DrawInstance(command.Texture, command.Sprite);
+            else
+            {
+                this->batch.Flush();
+                this->callbacks[command.Callback]();
+            }
+        }
+        this->batch.End();
+        // leave the default blend mode behind
+        if (blend != BLEND_ALPHA)
+            setBlend(BLEND_ALPHA);
+        this->commands.clear();
+        this->callbacks.clear();
+        this->sequence = 0;
+    }
+private:
+    SpriteBatch                        &batch;
+    unsigned int                        spriteShader;
+    unsigned int                        sequence;
+    std::vector<RenderCommand>          commands;
+    std::vector<std::function<void()>>  callbacks;
+
+    static void setBlend(BlendMode blend)
+    {
+        if (blend == BLEND_ADDITIVE)
+            GLState::get().blendFunc(GL_SRC_ALPHA, GL_ONE);
+        else
+            GLState::get().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+};
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "texture.h"
+#include "texture_atlas.h"
+#include "shader.h"
+
+// Per-instance state of a single batched sprite, laid out exactly as
+// it is streamed into the instance buffer
+struct SpriteInstance {
+    glm::vec2 Position;
+    glm::vec2 Size;
+    glm::vec3 Color;
+    float     Rotation; // in radians
+    glm::vec4 UV;       // <vec2 offset, vec2 scale> inside the texture
+};
+
+// SpriteBatch collects all sprites drawn between Begin() and End() into
+// an instance buffer. Every run of consecutive sprites sharing the same
+// texture is rendered with a single instanced draw call; the model matrix
+// is built in the vertex shader instead of on the CPU.
+class SpriteBatch
+{
+public:
+    // number of instanced draw calls issued since the last Begin()
+    unsigned int DrawCalls;
+    // constructor (inits shaders/shapes)
+    SpriteBatch(Shader shader, unsigned int capacity = 1024)
+        : DrawCalls(0), shader(shader), capacity(capacity), currentTexture(0), batching(false)
+    {
+        this->instances.reserve(capacity);
+        this->initRenderData();
+    }
+    ~SpriteBatch(){}
+    // starts collecting sprites
+    void Begin()
+    {
+        this->DrawCalls = 0;
+        this->instances.clear();
+        this->currentTexture = 0;
+        this->batching = true;
+    }
+    // queues a textured quad; the batch is flushed whenever the texture changes
+    void DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f), glm::vec4 uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f))
+    {
+        SpriteInstance instance;
+        instance.Position = position;
+        instance.Size = size;
+        instance.Color = color;
+        instance.Rotation = glm::radians(rotate);
+        instance.UV = uv;
+        this->DrawInstance(texture.ID, instance);
+    }
+    // queues a prepared instance textured with the given texture object
+    void DrawInstance(unsigned int texture, const SpriteInstance &instance)
+    {
+        if (texture != this->currentTexture || this->instances.size() >= this->capacity)
+        {
+            this->Flush();
+            this->currentTexture = texture;
+        }
+        this->instances.push_back(instance);
+        // outside of Begin()/End() every sprite is drawn right away
+        if (!this->batching)
+            this->Flush();
+    }
+    // queues a quad textured with a sprite from an atlas page; sprites sharing a page stay in one draw call
+    void DrawSprite(AtlasSprite &sprite, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f))
+    {
+        this->DrawSprite(sprite.Texture, position, size, rotate, color, sprite.UV);
+    }
+    // draws count prepared instances sharing one texture with a single
+    // instanced draw call, growing the instance buffer if they don't fit
+    void DrawInstances(unsigned int texture, const SpriteInstance *instances, unsigned int count)
+    {
+        this->Flush();
+        this->currentTexture = texture;
+        // Flush() reallocates the buffer at the current capacity anyway
+        if (count > this->capacity)
+            this->capacity = count;
+        this->instances.insert(this->instances.end(), instances, instances + count);
+        this->Flush();
+    }
+    // renders all remaining queued sprites and stops collecting
+    void End()
+    {
+        this->Flush();
+        this->batching = false;
+    }
+    // renders the queued run of sprites with one instanced draw call
+    void Flush()
+    {
+        if (this->instances.empty())
+            return;
+        this->shader.use();
+        GLState::get().activeTexture(GL_TEXTURE0);
+        GLState::get().bindTexture(this->currentTexture);
+        // orphan the previous buffer storage so we don't stall on draws still in flight
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, this->capacity * sizeof(SpriteInstance), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, this->instances.size() * sizeof(SpriteInstance), this->instances.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        GLState::get().bindVertexArray(this->quadVAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(this->instances.size()));
+
+        ++this->DrawCalls;
+        this->instances.clear();
+    }
+private:
+    // render state
+    Shader       shader;
+    unsigned int quadVAO, quadVBO, instanceVBO;
+    // batch state
+    std::vector<SpriteInstance> instances;
+    unsigned int capacity;
+    unsigned int currentTexture;
+    bool         batching;
+    // initializes and configures the quad's buffer and the per-instance vertex attributes
+    void initRenderData()
+    {
+        float vertices[] = { 
+            // pos      // tex
+            0.0f, 1.0f, 0.0f, 1.0f,
+            1.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 0.0f, 
+
+            0.0f, 1.0f, 0.0f, 1.0f,
+            1.0f, 1.0f, 1.0f, 1.0f,
+            1.0f, 0.0f, 1.0f, 0.0f
+        };
+
+        glGenVertexArrays(1, &this->quadVAO);
+        glGenBuffers(1, &this->quadVBO);
+        glGenBuffers(1, &this->instanceVBO);
+
+        GLState::get().bindVertexArray(this->quadVAO);
+        // static quad
+        glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        // per-instance attributes: <vec2 position, vec2 size>, <vec3 color, float rotation>, <vec2 uv offset, vec2 uv scale>
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, this->capacity * sizeof(SpriteInstance), NULL, GL_STREAM_DRAW);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, Position));
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, Color));
+        glVertexAttribDivisor(2, 1);
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, UV));
+        glVertexAttribDivisor(3, 1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        GLState::get().bindVertexArray(0);
+    }
+};
+
+#endif
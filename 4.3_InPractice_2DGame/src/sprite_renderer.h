@@ -5,6 +5,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "texture.h"
+#include "texture_atlas.h"
 #include "shader.h"
 
 class SpriteRenderer
@@ -13,6 +14,7 @@ private:
     // Render state
     Shader       shader; 
     unsigned int quadVAO;
+    UniformHandle modelUniform, colorUniform, uvUniform;
     // Initializes and configures the quad's buffer and vertex attributes
     void initRenderData()
     {
@@ -35,22 +37,25 @@ private:
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-        glBindVertexArray(this->quadVAO);
+        GLState::get().bindVertexArray(this->quadVAO);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        GLState::get().bindVertexArray(0);
     }
 public:
     // Constructor (inits shaders/shapes)
     SpriteRenderer(Shader shader)
     {
         this->shader = shader;
+        this->modelUniform = shader.handle("model");
+        this->colorUniform = shader.handle("spriteColor");
+        this->uvUniform = shader.handle("uvRect");
         this->initRenderData();
     }
     ~SpriteRenderer(){}
-    // Renders a defined quad textured with given sprite
-    void DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f))
+    // Renders a defined quad textured with given sprite; uv selects the <offset, scale> sub-rect of the texture to sample
+    void DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f), glm::vec4 uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f))
     {
         // prepare transformations
         this->shader.use();
@@ -63,17 +68,22 @@ public:
 
         model = glm::scale(model, glm::vec3(size, 1.0f)); // last scale
 
-        this->shader.setMat4("model", model);
+        this->shader.set(this->modelUniform, model);
 
         // render textured quad
-        this->shader.setVector3f("spriteColor", color);
+        this->shader.set(this->colorUniform, color);
+        this->shader.set(this->uvUniform, uv);
 
-        glActiveTexture(GL_TEXTURE0);
+        GLState::get().activeTexture(GL_TEXTURE0);
         texture.bind();
 
-        glBindVertexArray(this->quadVAO);
+        GLState::get().bindVertexArray(this->quadVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);    
+    }
+    // Renders a quad textured with a sprite from an atlas page
+    void DrawSprite(AtlasSprite &sprite, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f))
+    {
+        this->DrawSprite(sprite.Texture, position, size, rotate, color, sprite.UV);
     }
 };
 
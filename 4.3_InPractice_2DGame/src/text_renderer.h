@@ -1,7 +1,13 @@
 #ifndef TEXT_RENDERER_H
 #define TEXT_RENDERER_H
 
-#include <map>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -9,151 +15,650 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include "profiler.h"
+#include "resource_manager.h"
 #include "texture.h"
+#include "texture_atlas.h"
 #include "shader.h"
+#include "thread_pool.h"
 
 /// Holds all state information relevant to a character as loaded using FreeType
 struct Character {
-    unsigned int TextureID; // ID handle of the glyph texture
+    glm::vec4    UV;        // <vec2 offset, vec2 scale> of the glyph inside the glyph atlas
     glm::ivec2   Size;      // size of glyph
     glm::ivec2   Bearing;   // offset from baseline to left/top of glyph
     unsigned int Advance;   // horizontal offset to advance to next glyph
 };
 
-// A renderer class for rendering text displayed by a font loaded using the 
-// FreeType library. A single font is loaded, processed into a list of Character
-// items for later rendering.
+// Vertex of a glyph quad as streamed to the GPU
+struct TextVertex {
+    glm::vec2 Position;
+    glm::vec2 TexCoords;
+    glm::vec3 Color;
+};
+
+// A string laid out once and kept in the retained vertex buffer
+struct TextLayout {
+    std::string             Text;
+    float                   Scale;
+    glm::vec3               Color;
+    std::vector<TextVertex> Vertices; // glyph quads relative to the layout's origin
+    unsigned int            First;    // first vertex in the retained buffer
+    unsigned int            Reserved; // vertices set aside for the layout in the retained buffer
+    bool                    Owned;    // belongs to one handle and is rewritten in place by SetText(); cached layouts may be shared
+    unsigned int            Generation; // glyph atlas generation the quads were laid out against
+};
+// Identifies a cached TextLayout
+typedef unsigned int TextHandle;
+
+// How glyphs are stored in the atlas
+enum TextMode {
+    TEXT_BITMAP, // coverage bitmaps, crisp at scale 1.0 only
+    TEXT_SDF     // signed distance fields, crisp at any scale
+};
+
+// A renderer class for rendering text displayed by a font loaded using the
+// FreeType library. A single font is loaded and all its glyphs are packed
+// into one single-channel atlas texture. Text drawn between Begin() and
+// End() is collected into one vertex buffer and rendered with one draw call.
+// Static or rarely changing strings can instead be laid out once with
+// Layout() and drawn every frame with DrawText() without touching a glyph;
+// between Begin() and End() their quads join the batch. SetText() gives a
+// handle a layout of its own that is rewritten in place as the text changes.
+// In TEXT_SDF mode the atlas holds signed distance fields instead of
+// bitmaps, so a single font load renders sharp text at every scale.
+// Text is UTF-8: ASCII glyphs are packed when the font is loaded, any other
+// codepoint is rasterized the first time it is drawn into a free slot of
+// the atlas, evicting the least recently used glyph once the atlas is full.
 class TextRenderer
 {
 public:
-    // holds a list of pre-compiled Characters
-    std::map<char, Character> Characters; 
+    // number of codepoints loaded from the font
+    static const unsigned int GLYPH_COUNT = 128;
+    // distance fields are rasterized at least at this pixel size
+    static const unsigned int SDF_BASE_SIZE = 48;
+    // distance in pixels (at SDF_BASE_SIZE) covered by a distance field on either side of the outline
+    static const int          SDF_SPREAD = 6;
+    // smallest number of on-demand glyph slots the atlas is sized for
+    static const unsigned int MIN_GLYPH_SLOTS = 64;
+    // holds the pre-compiled ASCII Characters, indexed by codepoint
+    std::vector<Character> Characters;
     // shader used for text rendering
     Shader TextShader;
+    // number of draw calls issued since the last Begin()
+    unsigned int DrawCalls;
+    // glyph cache statistics for codepoints outside ASCII, which are rasterized on demand
+    unsigned int GlyphHits, GlyphMisses, GlyphEvictions;
     // constructor
-    TextRenderer(unsigned int width, unsigned int height)
-    {
-        // load and configure shader
-        this->TextShader = ResourceManager::loadShader(FileSystem::getPath("shaders/text_2d.vs").c_str(), FileSystem::getPath("shaders/text_2d.fs").c_str(), nullptr, "text");
-        this->TextShader.setMat4("projection", glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f), true);
-        this->TextShader.setInt("text", 0);
-        // configure VAO/VBO for texture quads
-        glGenVertexArrays(1, &this->VAO);
-        glGenBuffers(1, &this->VBO);
-        glBindVertexArray(this->VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+    TextRenderer()
+        : Characters(GLYPH_COUNT), DrawCalls(0), GlyphHits(0), GlyphMisses(0), GlyphEvictions(0), atlas(0), atlasSize(0), atlasGeneration(0), batching(false),
+          glyphScale(1.0f), retainedSize(0), retainedCapacity(0), ft(nullptr), face(nullptr), mode(TEXT_BITMAP), slotSize(0), slotsPerRow(0), slotTop(0), pinSerial(0), pinning(false), reportedFull(false)
+    {
+        // load the shader; distance field rendering is a variant of it, Load() picks the one matching the atlas
+        this->sdfVariant = ResourceManager::loadShader(FileSystem::getPath("shaders/text_2d.vs").c_str(), FileSystem::getPath("shaders/text_2d.fs").c_str(), nullptr, "text", { "SDF" }).key("SDF");
+        // configure VAO/VBO for texture quads, one pair for streamed and one for retained text
+        this->initVertexArray(this->VAO, this->VBO);
+        this->initVertexArray(this->retainedVAO, this->retainedVBO);
+    }
+    ~TextRenderer()
+    {
+        this->closeFont();
     }
-    // pre-compiles a list of characters from the given font
-    void Load(std::string font, unsigned int fontSize)
+    // pre-compiles a list of characters from the given font into the glyph atlas; a scale of 1.0 renders text at fontSize
+    void Load(std::string font, unsigned int fontSize, TextMode mode = TEXT_BITMAP)
     {
+        PROFILE_SCOPE("TextRenderer::Load");
         // first clear the previously loaded Characters
-        this->Characters.clear();
-        // then initialize and load the FreeType library
-        FT_Library ft;    
-        if (FT_Init_FreeType(&ft)) // all functions return a value different than 0 whenever an error occurred
+        std::fill(this->Characters.begin(), this->Characters.end(), Character());
+        this->useShader(mode);
+        // distance fields are generated from a large rasterization and scaled down while laying out text
+        unsigned int rasterSize = mode == TEXT_SDF ? std::max(fontSize, SDF_BASE_SIZE) : fontSize;
+        this->glyphScale = static_cast<float>(fontSize) / rasterSize;
+        // then initialize and load the FreeType library; the face stays open to rasterize glyphs on demand
+        this->closeFont();
+        if (FT_Init_FreeType(&this->ft)) // all functions return a value different than 0 whenever an error occurred
             std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
         // load font as face
-        FT_Face face;
-        if (FT_New_Face(ft, font.c_str(), 0, &face))
+        if (FT_New_Face(this->ft, font.c_str(), 0, &this->face))
+        {
             std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+            this->face = nullptr;
+        }
         // set size to load glyphs as
-        FT_Set_Pixel_Sizes(face, 0, fontSize);
-        // disable byte-alignment restriction
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); 
-        // then for the first 128 ASCII characters, pre-load/compile their characters and store them
-        for (GLubyte c = 0; c < 128; c++) // lol see what I did there 
+        if (this->face)
+            FT_Set_Pixel_Sizes(this->face, 0, rasterSize);
+        this->mode = mode;
+        // then for the first 128 ASCII characters, rasterize their glyphs and keep the bitmaps for packing
+        std::vector<AtlasImage> bitmaps;
+        for (unsigned int c = 0; c < GLYPH_COUNT && this->face; c++)
         {
-            // load character glyph 
-            if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-            {
-                std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+            AtlasImage image;
+            if (!this->rasterize(c, this->Characters[c], image))
                 continue;
-            }
-            // generate texture
-            unsigned int texture;
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                GL_RED,
-                face->glyph->bitmap.width,
-                face->glyph->bitmap.rows,
-                0,
-                GL_RED,
-                GL_UNSIGNED_BYTE,
-                face->glyph->bitmap.buffer
-            );
-            // set texture options
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            // now store character for later use
-            Character character = {
-                texture,
-                glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-                glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-                face->glyph->advance.x
-            };
-            Characters.insert(std::pair<char, Character>(c, character));
-        }
-        glBindTexture(GL_TEXTURE_2D, 0);
-        // destroy FreeType once we're finished
-        FT_Done_Face(face);
-        FT_Done_FreeType(ft);
-    }
-    // renders a string of text using the precompiled list of characters
+            image.Name = std::string(1, static_cast<char>(c));
+            if (image.Width > 0 && image.Height > 0)
+                bitmaps.push_back(image);
+        }
+        if (mode == TEXT_SDF)
+        {
+            // the glyphs are independent, so convert them on all cores
+            ThreadPool workers;
+            workers.ParallelFor(static_cast<unsigned int>(bitmaps.size()), [&bitmaps](unsigned int i) {
+                makeDistanceField(bitmaps[i], SDF_SPREAD);
+            });
+            // the quads grow by the spread on every side
+            for (Character &ch : this->Characters)
+                padMetrics(ch);
+        }
+        // glyphs beyond ASCII are rasterized on demand into uniform slots; size them after a full em square
+        this->slotSize = rasterSize + rasterSize / 4 + 2 * (mode == TEXT_SDF ? SDF_SPREAD : 0) + 2;
+        this->buildAtlas(bitmaps);
+        // glyph metrics and UVs changed, so lay out all cached strings again
+        ++this->atlasGeneration;
+        for (TextLayout &layout : this->layouts)
+            this->layoutText(layout);
+        this->uploadRetained(0);
+    }
+    // starts collecting text; everything rendered until End() is drawn with one call
+    void Begin()
+    {
+        this->DrawCalls = 0;
+        this->vertices.clear();
+        this->batching = true;
+    }
+    // draws all collected text
+    void End()
+    {
+        this->Flush();
+        this->batching = false;
+    }
+    // lays out a string of text using the precompiled list of characters
     void RenderText(std::string text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f))
     {
-        // activate corresponding render state	
+        this->appendGlyphs(this->vertices, text, x, y, scale, color);
+        // outside of Begin()/End() every string is drawn right away
+        if (!this->batching)
+            this->Flush();
+    }
+    // returns the cached layout of a string, laying it out on first use
+    TextHandle Layout(const std::string &text, float scale, glm::vec3 color = glm::vec3(1.0f))
+    {
+        std::string key = layoutKey(text, scale, color);
+        auto iter = this->layoutCache.find(key);
+        if (iter != this->layoutCache.end())
+            return iter->second;
+        TextLayout layout;
+        layout.Text = text;
+        layout.Scale = scale;
+        layout.Color = color;
+        layout.First = 0;
+        layout.Reserved = 0;
+        layout.Owned = false;
+        this->layoutText(layout);
+        this->layouts.push_back(layout);
+        TextHandle handle = static_cast<TextHandle>(this->layouts.size() - 1);
+        this->layoutCache[key] = handle;
+        this->uploadRetained(handle);
+        return handle;
+    }
+    // changes the text of a handle, keeping its scale and color; nothing is laid out if the text didn't change.
+    // The first change moves the handle to a layout of its own, later ones lay out that one again in place.
+    void SetText(TextHandle &handle, const std::string &text)
+    {
+        if (this->layouts[handle].Text == text)
+            return;
+        if (!this->layouts[handle].Owned)
+        {
+            TextLayout layout = this->layouts[handle];
+            layout.Text = text;
+            layout.Reserved = 0;
+            layout.Owned = true;
+            this->layoutText(layout);
+            this->layouts.push_back(layout);
+            handle = static_cast<TextHandle>(this->layouts.size() - 1);
+            this->uploadRetained(handle);
+            return;
+        }
+        this->layouts[handle].Text = text;
+        this->refreshLayout(handle);
+    }
+    // draws a cached layout with its origin at (x, y)
+    void DrawText(TextHandle handle, float x, float y)
+    {
+        PROFILE_SCOPE("TextRenderer::DrawText");
+        if (this->layouts[handle].Generation != this->atlasGeneration)
+            this->refreshLayout(handle);
+        const TextLayout &layout = this->layouts[handle];
+        if (layout.Vertices.empty())
+            return;
+        if (this->batching)
+        {
+            // the quads are already laid out, they only need moving to (x, y)
+            glm::vec2 offset(x, y);
+            for (const TextVertex &vertex : layout.Vertices)
+            {
+                this->vertices.push_back(vertex);
+                this->vertices.back().Position += offset;
+            }
+            return;
+        }
+        PROFILE_GPU_SCOPE("TextRenderer::DrawText");
         this->TextShader.use();
-        this->TextShader.setVector3f("textColor", color);
-        glActiveTexture(GL_TEXTURE0);
-        glBindVertexArray(this->VAO);
+        this->TextShader.set(this->offsetUniform, glm::vec2(x, y));
+        GLState::get().activeTexture(GL_TEXTURE0);
+        GLState::get().bindTexture(this->atlas);
+        GLState::get().bindVertexArray(this->retainedVAO);
+        glDrawArrays(GL_TRIANGLES, layout.First, static_cast<GLsizei>(layout.Vertices.size()));
+        ++this->DrawCalls;
+    }
+    // renders all collected glyph quads with a single draw call
+    void Flush()
+    {
+        if (this->vertices.empty())
+            return;
+        PROFILE_SCOPE("TextRenderer::Flush");
+        PROFILE_GPU_SCOPE("TextRenderer::Flush");
+        // activate corresponding render state
+        this->TextShader.use();
+        this->TextShader.set(this->offsetUniform, glm::vec2(0.0f));
+        GLState::get().activeTexture(GL_TEXTURE0);
+        GLState::get().bindTexture(this->atlas);
+        // orphan the previous buffer storage so we don't stall on draws still in flight
+        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+        glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(TextVertex), this->vertices.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // render quads
+        GLState::get().bindVertexArray(this->VAO);
+        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(this->vertices.size()));
+        ++this->DrawCalls;
+        this->vertices.clear();
+    }
+private:
+    // render state
+    unsigned int VAO, VBO;
+    unsigned int atlas, atlasSize;
+    // bumped whenever glyphs move or leave the atlas, invalidating retained layouts
+    unsigned int atlasGeneration;
+    std::vector<TextVertex> vertices;
+    bool batching;
+    UniformHandle offsetUniform;
+    // variant key of the distance field text shader
+    unsigned int sdfVariant;
+    // converts glyph metrics from rasterized pixels to fontSize pixels
+    float glyphScale;
+    // retained text state
+    unsigned int retainedVAO, retainedVBO;
+    unsigned int retainedSize, retainedCapacity; // in vertices
+    std::vector<TextLayout> layouts;
+    std::unordered_map<std::string, TextHandle> layoutCache;
+
+    // configures a VAO/VBO pair for TextVertex data
+    void initVertexArray(unsigned int &vao, unsigned int &vbo)
+    {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        GLState::get().bindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, Position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, Color));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        GLState::get().bindVertexArray(0);
+    }
+    // an on-demand glyph and its place in the atlas
+    struct CachedGlyph {
+        Character                   Glyph;
+        unsigned int                Slot;
+        std::list<char32_t>::iterator Use; // position in the LRU list
+        unsigned int                Pin; // pinSerial of the last layout that used it
+    };
+    // FreeType state, kept open for on-demand glyphs
+    FT_Library ft;
+    FT_Face    face;
+    TextMode   mode;
+    // glyph cache; the atlas below the packed ASCII glyphs is split into square slots
+    unsigned int slotSize, slotsPerRow, slotTop;
+    std::vector<unsigned int> freeSlots;
+    std::unordered_map<char32_t, CachedGlyph> glyphs;
+    std::list<char32_t> glyphUse; // most recently used first
+    // glyphs of the layout being built can't be evicted, or a string with more distinct glyphs than
+    // there are slots would evict its own glyphs and be laid out again every frame
+    unsigned int pinSerial;
+    bool pinning, reportedFull;
+
+    void closeFont()
+    {
+        if (this->face)
+            FT_Done_Face(this->face);
+        if (this->ft)
+            FT_Done_FreeType(this->ft);
+        this->face = nullptr;
+        this->ft = nullptr;
+    }
+    // decodes the codepoint starting at byte i and advances i past it; malformed sequences yield U+FFFD
+    static char32_t decodeUtf8(const std::string &text, std::size_t &i)
+    {
+        unsigned char lead = static_cast<unsigned char>(text[i++]);
+        if (lead < 0x80)
+            return lead;
+        unsigned int length = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+        if (length == 0 || lead >= 0xF8)
+            return 0xFFFD;
+        char32_t codepoint = lead & (0x3F >> length);
+        for (unsigned int n = 0; n < length; ++n)
+        {
+            if (i >= text.size() || (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80)
+                return 0xFFFD;
+            codepoint = (codepoint << 6) | (static_cast<unsigned char>(text[i++]) & 0x3F);
+        }
+        return codepoint;
+    }
+    // returns the glyph of a codepoint, rasterizing it into the atlas if it isn't cached; nullptr if the font can't provide it
+    const Character *glyph(char32_t codepoint)
+    {
+        if (codepoint < GLYPH_COUNT)
+            return &this->Characters[codepoint];
+        auto iter = this->glyphs.find(codepoint);
+        if (iter != this->glyphs.end())
+        {
+            ++this->GlyphHits;
+            if (this->pinning)
+                iter->second.Pin = this->pinSerial;
+            this->glyphUse.splice(this->glyphUse.begin(), this->glyphUse, iter->second.Use);
+            return &iter->second.Glyph;
+        }
+        ++this->GlyphMisses;
+        Character ch;
+        AtlasImage image;
+        if (!this->face || !this->rasterize(codepoint, ch, image))
+            return nullptr;
+        if (this->mode == TEXT_SDF && image.Width > 0 && image.Height > 0)
+        {
+            makeDistanceField(image, SDF_SPREAD);
+            padMetrics(ch);
+        }
+        if (image.Width + 2 > this->slotSize || image.Height + 2 > this->slotSize)
+        {
+            std::cout << "ERROR::TEXT: Glyph U+" << std::hex << static_cast<unsigned int>(codepoint) << std::dec << " does not fit into a glyph slot" << std::endl;
+            return nullptr;
+        }
+        unsigned int slot;
+        if (!this->allocateSlot(slot))
+            return nullptr;
+        this->uploadSlot(slot, image, ch);
+        this->glyphUse.push_front(codepoint);
+        CachedGlyph &cached = this->glyphs[codepoint];
+        cached.Glyph = ch;
+        cached.Slot = slot;
+        cached.Use = this->glyphUse.begin();
+        cached.Pin = this->pinning ? this->pinSerial : 0;
+        return &cached.Glyph;
+    }
+    // takes a free slot, evicting the least recently used glyph if there is none
+    bool allocateSlot(unsigned int &slot)
+    {
+        if (!this->freeSlots.empty())
+        {
+            slot = this->freeSlots.back();
+            this->freeSlots.pop_back();
+            return true;
+        }
+        if (this->glyphUse.empty())
+            return false;
+        // pinned glyphs were used last, so if the least recently used one is pinned all of them are
+        if (this->pinning && this->glyphs[this->glyphUse.back()].Pin == this->pinSerial)
+        {
+            if (!this->reportedFull)
+                std::cout << "ERROR::TEXT: A laid-out string uses more glyphs than the atlas has slots; the rest are left out" << std::endl;
+            this->reportedFull = true;
+            return false;
+        }
+        // quads already collected may still reference the evicted glyph, so draw them first
+        this->Flush();
+        char32_t victim = this->glyphUse.back();
+        this->glyphUse.pop_back();
+        slot = this->glyphs[victim].Slot;
+        this->glyphs.erase(victim);
+        ++this->GlyphEvictions;
+        // retained layouts may have used the evicted glyph
+        ++this->atlasGeneration;
+        return true;
+    }
+    // writes a glyph image into its slot, clearing what was left there by an evicted glyph
+    void uploadSlot(unsigned int slot, const AtlasImage &image, Character &ch)
+    {
+        unsigned int x = (slot % this->slotsPerRow) * this->slotSize;
+        unsigned int y = this->slotTop + (slot / this->slotsPerRow) * this->slotSize;
+        std::vector<GLubyte> pixels(this->slotSize * this->slotSize, 0);
+        for (unsigned int row = 0; row < image.Height; ++row)
+            std::copy(image.Pixels.begin() + row * image.Width, image.Pixels.begin() + (row + 1) * image.Width, pixels.begin() + (row + 1) * this->slotSize + 1);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        GLState::get().bindTexture(this->atlas);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, this->slotSize, this->slotSize, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+        float size = static_cast<float>(this->atlasSize);
+        ch.UV = glm::vec4((x + 1) / size, (y + 1) / size, image.Width / size, image.Height / size);
+    }
+    // loads the metrics and coverage bitmap of a codepoint
+    bool rasterize(char32_t codepoint, Character &character, AtlasImage &image)
+    {
+        // load character glyph
+        if (FT_Load_Char(this->face, codepoint, FT_LOAD_RENDER))
+        {
+            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+            return false;
+        }
+        FT_Bitmap &bitmap = this->face->glyph->bitmap;
+        character.Size = glm::ivec2(bitmap.width, bitmap.rows);
+        character.Bearing = glm::ivec2(this->face->glyph->bitmap_left, this->face->glyph->bitmap_top);
+        character.Advance = static_cast<unsigned int>(this->face->glyph->advance.x);
+        image.Width = bitmap.width;
+        image.Height = bitmap.rows;
+        image.Pixels.clear();
+        for (unsigned int row = 0; row < bitmap.rows; ++row)
+            image.Pixels.insert(image.Pixels.end(), bitmap.buffer + row * bitmap.pitch, bitmap.buffer + row * bitmap.pitch + bitmap.width);
+        return true;
+    }
+    // grows the quad of a glyph by the distance field spread on every side
+    static void padMetrics(Character &ch)
+    {
+        if (ch.Size.x == 0 || ch.Size.y == 0)
+            return;
+        ch.Size += glm::ivec2(2 * SDF_SPREAD);
+        ch.Bearing += glm::ivec2(-SDF_SPREAD, SDF_SPREAD);
+    }
+    // lays out a retained string again, after glyphs it used were evicted or its text changed
+    void refreshLayout(TextHandle handle)
+    {
+        TextLayout &layout = this->layouts[handle];
+        this->layoutText(layout);
+        if (layout.Vertices.size() > layout.Reserved)
+        {
+            // outgrew its range; leave room to grow further and place all layouts again
+            layout.Reserved = std::max(static_cast<unsigned int>(layout.Vertices.size()), layout.Reserved * 2);
+            this->uploadRetained(0);
+            return;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, this->retainedVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, layout.First * sizeof(TextVertex), layout.Vertices.size() * sizeof(TextVertex), layout.Vertices.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    // switches to the text shader matching the atlas contents
+    void useShader(TextMode mode)
+    {
+        this->TextShader = ResourceManager::getShader("text", mode == TEXT_SDF ? this->sdfVariant : 0);
+        this->TextShader.setInt("text", 0, true);
+        this->offsetUniform = this->TextShader.handle("offset");
+    }
+    // replaces a coverage bitmap by a signed distance field, padded by spread pixels on every side;
+    // 0.5 lies on the outline, larger values are inside the glyph
+    static void makeDistanceField(AtlasImage &image, int spread)
+    {
+        int w = static_cast<int>(image.Width), h = static_cast<int>(image.Height);
+        int fieldW = w + 2 * spread, fieldH = h + 2 * spread;
+        auto inside = [&image, w, h, spread](int x, int y) {
+            x -= spread;
+            y -= spread;
+            return x >= 0 && y >= 0 && x < w && y < h && image.Pixels[y * w + x] >= 128;
+        };
+        std::vector<GLubyte> field(fieldW * fieldH);
+        for (int y = 0; y < fieldH; ++y)
+        {
+            for (int x = 0; x < fieldW; ++x)
+            {
+                // search the closest texel on the other side of the outline within the spread
+                bool in = inside(x, y);
+                int best = (spread + 1) * (spread + 1);
+                for (int dy = -spread; dy <= spread; ++dy)
+                    for (int dx = -spread; dx <= spread; ++dx)
+                        if (dx * dx + dy * dy < best && inside(x + dx, y + dy) != in)
+                            best = dx * dx + dy * dy;
+                // the outline runs halfway between two texels
+                float distance = std::sqrt(static_cast<float>(best)) - 0.5f;
+                float value = 0.5f + 0.5f * (in ? distance : -distance) / spread;
+                field[y * fieldW + x] = static_cast<GLubyte>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+            }
+        }
+        image.Width = fieldW;
+        image.Height = fieldH;
+        image.Pixels.swap(field);
+    }
+    // appends the glyph quads of a string to out
+    void appendGlyphs(std::vector<TextVertex> &out, const std::string &text, float x, float y, float scale, glm::vec3 color)
+    {
+        scale *= this->glyphScale;
+        // align all glyphs to the top of the capital H
+        float top = static_cast<float>(this->Characters['H'].Bearing.y);
         // iterate through all characters
-        std::string::const_iterator c;
-        for (c = text.begin(); c != text.end(); c++)
+        for (std::size_t i = 0; i < text.size();)
         {
-            Character ch = Characters[*c];
+            const Character *glyph = this->glyph(decodeUtf8(text, i));
+            if (!glyph)
+                continue;
+            const Character &ch = *glyph;
 
             float xpos = x + ch.Bearing.x * scale;
-            float ypos = y + (this->Characters['H'].Bearing.y - ch.Bearing.y) * scale;
+            float ypos = y + (top - ch.Bearing.y) * scale;
 
             float w = ch.Size.x * scale;
             float h = ch.Size.y * scale;
-            // update VBO for each character
-            float vertices[6][4] = {
-                { xpos,     ypos + h,   0.0f, 1.0f },
-                { xpos + w, ypos,       1.0f, 0.0f },
-                { xpos,     ypos,       0.0f, 0.0f },
-
-                { xpos,     ypos + h,   0.0f, 1.0f },
-                { xpos + w, ypos + h,   1.0f, 1.0f },
-                { xpos + w, ypos,       1.0f, 0.0f }
-            };
-            // render glyph texture over quad
-            glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-            // update content of VBO memory
-            glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // be sure to use glBufferSubData and not glBufferData
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            // render quad
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+            if (w > 0.0f && h > 0.0f)
+            {
+                float u0 = ch.UV.x, v0 = ch.UV.y;
+                float u1 = ch.UV.x + ch.UV.z, v1 = ch.UV.y + ch.UV.w;
+                TextVertex quad[6] = {
+                    { glm::vec2(xpos,     ypos + h), glm::vec2(u0, v1), color },
+                    { glm::vec2(xpos + w, ypos),     glm::vec2(u1, v0), color },
+                    { glm::vec2(xpos,     ypos),     glm::vec2(u0, v0), color },
+
+                    { glm::vec2(xpos,     ypos + h), glm::vec2(u0, v1), color },
+                    { glm::vec2(xpos + w, ypos + h), glm::vec2(u1, v1), color },
+                    { glm::vec2(xpos + w, ypos),     glm::vec2(u1, v0), color }
+                };
+                out.insert(out.end(), quad, quad + 6);
+            }
             // now advance cursors for next glyph
             x += (ch.Advance >> 6) * scale; // bitshift by 6 to get value in pixels (1/64th times 2^6 = 64)
         }
-        glBindVertexArray(0);
-        glBindTexture(GL_TEXTURE_2D, 0);
     }
-private:
-    // render state
-    unsigned int VAO, VBO;
+    // (re)builds the glyph quads of a layout
+    void layoutText(TextLayout &layout)
+    {
+        layout.Vertices.clear();
+        ++this->pinSerial;
+        this->pinning = true;
+        this->appendGlyphs(layout.Vertices, layout.Text, 0.0f, 0.0f, layout.Scale, layout.Color);
+        this->pinning = false;
+        // taken after laying out, since evicting other glyphs for it bumps the generation
+        layout.Generation = this->atlasGeneration;
+    }
+    // places the layouts from index first onwards behind the ones already in the retained buffer and uploads them
+    void uploadRetained(std::size_t first)
+    {
+        unsigned int size = first == 0 ? 0 : this->retainedSize;
+        for (std::size_t i = first; i < this->layouts.size(); ++i)
+        {
+            TextLayout &layout = this->layouts[i];
+            layout.First = size;
+            layout.Reserved = std::max(layout.Reserved, static_cast<unsigned int>(layout.Vertices.size()));
+            size += layout.Reserved;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, this->retainedVBO);
+        if (size > this->retainedCapacity)
+        {
+            // grow geometrically and upload everything into the new storage
+            this->retainedCapacity = std::max(size, this->retainedCapacity * 2);
+            glBufferData(GL_ARRAY_BUFFER, this->retainedCapacity * sizeof(TextVertex), NULL, GL_STATIC_DRAW);
+            first = 0;
+        }
+        for (std::size_t i = first; i < this->layouts.size(); ++i)
+        {
+            const TextLayout &layout = this->layouts[i];
+            glBufferSubData(GL_ARRAY_BUFFER, layout.First * sizeof(TextVertex), layout.Vertices.size() * sizeof(TextVertex), layout.Vertices.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        this->retainedSize = size;
+    }
+    // cache key of a (text, scale, color) combination
+    static std::string layoutKey(const std::string &text, float scale, glm::vec3 color)
+    {
+        std::string key = text;
+        key.append(reinterpret_cast<const char*>(&scale), sizeof(scale));
+        key.append(reinterpret_cast<const char*>(&color), sizeof(color));
+        return key;
+    }
+
+    // packs the glyph bitmaps into a single GL_R8 texture, growing the atlas until they all fit
+    void buildAtlas(std::vector<AtlasImage> &bitmaps)
+    {
+        std::sort(bitmaps.begin(), bitmaps.end(), [](const AtlasImage &a, const AtlasImage &b) {
+            return a.Height > b.Height;
+        });
+        std::vector<glm::ivec2> origins(bitmaps.size());
+        for (this->atlasSize = 128; this->atlasSize <= 4096; this->atlasSize *= 2)
+        {
+            RectPacker packer(this->atlasSize, this->atlasSize, 1);
+            bool fits = true;
+            for (unsigned int i = 0; i < bitmaps.size() && fits; ++i)
+                fits = packer.pack(bitmaps[i].Width, bitmaps[i].Height, origins[i]);
+            // the rows below the packed glyphs are left for on-demand glyphs
+            this->slotTop = packer.usedHeight();
+            this->slotsPerRow = this->atlasSize / this->slotSize;
+            unsigned int slots = this->slotsPerRow * ((this->atlasSize - std::min(this->slotTop, this->atlasSize)) / this->slotSize);
+            if (fits && (slots >= MIN_GLYPH_SLOTS || this->atlasSize == 4096))
+                break;
+        }
+        // forget all on-demand glyphs
+        this->glyphs.clear();
+        this->glyphUse.clear();
+        this->freeSlots.clear();
+        unsigned int slotRows = this->slotTop < this->atlasSize ? (this->atlasSize - this->slotTop) / this->slotSize : 0;
+        for (unsigned int slot = this->slotsPerRow * slotRows; slot-- > 0;)
+            this->freeSlots.push_back(slot);
+        std::vector<GLubyte> pixels(this->atlasSize * this->atlasSize, 0);
+        float size = static_cast<float>(this->atlasSize);
+        for (unsigned int i = 0; i < bitmaps.size(); ++i)
+        {
+            const AtlasImage &image = bitmaps[i];
+            for (unsigned int row = 0; row < image.Height; ++row)
+                std::copy(image.Pixels.begin() + row * image.Width, image.Pixels.begin() + (row + 1) * image.Width, pixels.begin() + (origins[i].y + row) * this->atlasSize + origins[i].x);
+            Character &ch = this->Characters[static_cast<unsigned char>(image.Name[0])];
+            ch.UV = glm::vec4(origins[i].x / size, origins[i].y / size, image.Width / size, image.Height / size);
+        }
+        // upload the atlas
+        if (this->atlas == 0)
+            glGenTextures(1, &this->atlas);
+        // disable byte-alignment restriction
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        GLState::get().bindTexture(this->atlas);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, this->atlasSize, this->atlasSize, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+        // set texture options
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GLState::get().bindTexture(0);
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,156 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+// Shadows the GL binding state the renderers touch most: the current
+// program, vertex array, active texture unit, 2D texture per unit, blend
+// function and framebuffers. A call that would not change the driver's
+// state is skipped and counted. All binds in the tree go through this
+// cache; code that changes these bindings behind its back has to call
+// invalidate() afterwards.
+class GLState
+{
+public:
+    static const unsigned int MAX_TEXTURE_UNITS = 16;
+    // calls forwarded to GL and calls skipped since beginFrame()
+    unsigned int Issued, Skipped;
+    // the same counters for the previous frame
+    unsigned int IssuedLastFrame, SkippedLastFrame;
+
+    // the state of the current context
+    static GLState &get()
+    {
+        static GLState state;
+        return state;
+    }
+    // starts counting calls for a new frame
+    void beginFrame()
+    {
+        this->IssuedLastFrame = this->Issued;
+        this->SkippedLastFrame = this->Skipped;
+        this->Issued = this->Skipped = 0;
+    }
+    // forgets everything, so the next call of each kind always reaches GL
+    void invalidate()
+    {
+        this->known = 0;
+    }
+
+    void useProgram(unsigned int program)
+    {
+        if (this->skip(KNOWN_PROGRAM, this->program == program))
+            return;
+        this->program = program;
+        glUseProgram(program);
+    }
+    void bindVertexArray(unsigned int vao)
+    {
+        if (this->skip(KNOWN_VERTEX_ARRAY, this->vertexArray == vao))
+            return;
+        this->vertexArray = vao;
+        glBindVertexArray(vao);
+    }
+    // unit is GL_TEXTURE0 + n
+    void activeTexture(unsigned int unit)
+    {
+        if (this->skip(KNOWN_ACTIVE_TEXTURE, this->activeUnit == unit))
+            return;
+        this->activeUnit = unit;
+        glActiveTexture(unit);
+    }
+    // binds a 2D texture to the active texture unit
+    void bindTexture(unsigned int texture)
+    {
+        unsigned int unit = this->activeUnit - GL_TEXTURE0;
+        bool unitKnown = (this->known & KNOWN_ACTIVE_TEXTURE) && unit < MAX_TEXTURE_UNITS;
+        if (unitKnown && this->skip(KNOWN_TEXTURE << unit, this->textures[unit] == texture))
+            return;
+        if (!unitKnown)
+            ++this->Issued;
+        else
+            this->textures[unit] = texture;
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+    void blendFunc(unsigned int source, unsigned int destination)
+    {
+        if (this->skip(KNOWN_BLEND, this->blendSource == source && this->blendDestination == destination))
+            return;
+        this->blendSource = source;
+        this->blendDestination = destination;
+        glBlendFunc(source, destination);
+    }
+    // target is GL_FRAMEBUFFER (read and draw), GL_READ_FRAMEBUFFER or GL_DRAW_FRAMEBUFFER
+    void bindFramebuffer(unsigned int target, unsigned int framebuffer)
+    {
+        bool read = target != GL_DRAW_FRAMEBUFFER, draw = target != GL_READ_FRAMEBUFFER;
+        bool same = (!read || this->readFramebuffer == framebuffer) && (!draw || this->drawFramebuffer == framebuffer);
+        unsigned int flags = (read ? KNOWN_READ_FRAMEBUFFER : 0) | (draw ? KNOWN_DRAW_FRAMEBUFFER : 0);
+        if (this->skip(flags, same))
+            return;
+        if (read)
+            this->readFramebuffer = framebuffer;
+        if (draw)
+            this->drawFramebuffer = framebuffer;
+        glBindFramebuffer(target, framebuffer);
+    }
+    // deleting a bound object reverts its binding to 0, which the cache has to follow
+    void deleteVertexArray(unsigned int vao)
+    {
+        glDeleteVertexArrays(1, &vao);
+        if (this->vertexArray == vao)
+            this->vertexArray = 0;
+    }
+    void deleteTexture(unsigned int texture)
+    {
+        glDeleteTextures(1, &texture);
+        for (unsigned int i = 0; i < MAX_TEXTURE_UNITS; ++i)
+            if (this->textures[i] == texture)
+                this->textures[i] = 0;
+    }
+    // currently bound program, as far as the cache knows
+    unsigned int currentProgram() const
+    {
+        return (this->known & KNOWN_PROGRAM) ? this->program : 0;
+    }
+private:
+    enum {
+        KNOWN_PROGRAM          = 1 << 0,
+        KNOWN_VERTEX_ARRAY     = 1 << 1,
+        KNOWN_ACTIVE_TEXTURE   = 1 << 2,
+        KNOWN_BLEND            = 1 << 3,
+        KNOWN_READ_FRAMEBUFFER = 1 << 4,
+        KNOWN_DRAW_FRAMEBUFFER = 1 << 5,
+        KNOWN_TEXTURE          = 1 << 6 // one bit per texture unit from here on
+    };
+    unsigned int known; // which of the values below reflect the driver's state
+    unsigned int program, vertexArray, activeUnit;
+    unsigned int textures[MAX_TEXTURE_UNITS];
+    unsigned int blendSource, blendDestination;
+    unsigned int readFramebuffer, drawFramebuffer;
+
+    GLState()
+        : Issued(0), Skipped(0), IssuedLastFrame(0), SkippedLastFrame(0), known(0), program(0), vertexArray(0), activeUnit(GL_TEXTURE0),
+          blendSource(GL_ONE), blendDestination(GL_ZERO), readFramebuffer(0), drawFramebuffer(0)
+    {
+        for (unsigned int i = 0; i < MAX_TEXTURE_UNITS; ++i)
+            this->textures[i] = 0;
+    }
+    GLState(const GLState&);
+    GLState &operator=(const GLState&);
+
+    // counts the call; returns true if it can be skipped, otherwise marks the state as known
+    bool skip(unsigned int flags, bool same)
+    {
+        if ((this->known & flags) == flags && same)
+        {
+            ++this->Skipped;
+            return true;
+        }
+        this->known |= flags;
+        ++this->Issued;
+        return false;
+    }
+};
+
+#endif
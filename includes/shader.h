@@ -6,16 +6,34 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "gl_state.h"
+
+// A uniform location resolved once by name. Pass it to the typed set()
+// functions of the Shader it came from to skip the string lookup.
+struct UniformHandle
+{
+    int Location; // -1 if the uniform is not active in the program
+    int Slot;     // index into the shader's value cache, -1 if not cached
+
+    UniformHandle() : Location(-1), Slot(-1) {}
+    UniformHandle(int location, int slot) : Location(location), Slot(slot) {}
+    bool valid() const { return this->Location >= 0; }
+};
+
 class Shader 
 {
 public:
     unsigned int ID;
     // constructor generates the shader on the fly
     // -------------------------------------------
-    Shader() = default;
+    Shader() : ID(0) {}
     Shader(const char* vertexPath, const char* fragmentPath)
     {
         // 1.retrieve the vertex/fragment source code from filePath
@@ -69,10 +87,11 @@ public:
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
+        reflectUniforms();
     }
-    // compile shader
+    // compile shader; a retrievable program can be saved with glGetProgramBinary
     // ------------------
-    void compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource)
+    void compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource, bool retrievable = false)
     {
         unsigned int sVertex, sFragment, gShader;
         // vertex Shader
@@ -99,6 +118,8 @@ public:
         glAttachShader(this->ID, sFragment);
         if (geometrySource != nullptr)
             glAttachShader(this->ID, gShader);
+        if (retrievable && glad_glProgramParameteri)
+            glProgramParameteri(this->ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
         glLinkProgram(this->ID);
         checkCompileErrors(this->ID, "PROGRAM");
         // delete the shaders as they're linked into our program now and no longer necessary
@@ -106,82 +127,222 @@ public:
         glDeleteShader(sFragment);
         if (geometrySource != nullptr)
             glDeleteShader(gShader);
+        reflectUniforms();
+    }
+    // create the program from a binary saved by glGetProgramBinary; returns false if the driver rejects it
+    // ------------------
+    bool loadBinary(unsigned int format, const void* binary, int length)
+    {
+        // needs OpenGL 4.1
+        if (!glad_glProgramBinary)
+            return false;
+        this->ID = glCreateProgram();
+        glProgramBinary(this->ID, format, binary, length);
+        int success;
+        glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glDeleteProgram(this->ID);
+            this->ID = 0;
+            return false;
+        }
+        reflectUniforms();
+        return true;
     }
 
     // activate the shader
     // -------------------
     void activate() const
     {
-        glUseProgram(ID);
+        GLState::get().useProgram(ID);
     }
     void deactivate() const
     {
-        glUseProgram(0);
+        GLState::get().useProgram(0);
     }
     Shader &use()
     {
-        glUseProgram(this->ID);
+        GLState::get().useProgram(this->ID);
         return *this;
     }
+    // binds the named uniform block, if the program uses it, to a uniform buffer binding point
+    void bindUniformBlock(const char *name, unsigned int binding) const
+    {
+        unsigned int index = glGetUniformBlockIndex(ID, name);
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, binding);
+    }
+    // uniform handles
+    // ---------------
+    // resolves a uniform by name; all active uniforms were looked up when the program was linked
+    UniformHandle handle(const std::string& name) const
+    {
+        if (!uniforms)
+            return UniformHandle(glGetUniformLocation(ID, name.c_str()), -1);
+        auto iter = uniforms->Handles.find(name);
+        if (iter != uniforms->Handles.end())
+            return iter->second;
+        // not reflected (e.g. an array element other than [0]); look it up once and remember it
+        UniformHandle handle(glGetUniformLocation(ID, name.c_str()), -1);
+        if (handle.valid())
+            handle.Slot = uniforms->addSlot();
+        uniforms->Handles[name] = handle;
+        return handle;
+    }
+    // typed uniform functions; uploads are skipped when the program already holds the value
+    // ----------------------------------------------------------------------------------------
+    void set(UniformHandle handle, int value) const
+    {
+        if (changed(handle, &value, sizeof(value)))
+            glUniform1i(handle.Location, value);
+    }
+    void set(UniformHandle handle, float value) const
+    {
+        if (changed(handle, &value, sizeof(value)))
+            glUniform1f(handle.Location, value);
+    }
+    void set(UniformHandle handle, const glm::vec2 &value) const
+    {
+        if (changed(handle, &value, sizeof(value)))
+            glUniform2f(handle.Location, value.x, value.y);
+    }
+    void set(UniformHandle handle, const glm::vec3 &value) const
+    {
+        if (changed(handle, &value, sizeof(value)))
+            glUniform3f(handle.Location, value.x, value.y, value.z);
+    }
+    void set(UniformHandle handle, const glm::vec4 &value) const
+    {
+        if (changed(handle, &value, sizeof(value)))
+            glUniform4f(handle.Location, value.x, value.y, value.z, value.w);
+    }
+    void set(UniformHandle handle, const glm::mat4 &mat) const
+    {
+        if (changed(handle, &mat[0][0], sizeof(mat)))
+            glUniformMatrix4fv(handle.Location, 1, GL_FALSE, &mat[0][0]);
+    }
     // utility uniform functions
     // --------------------------
     void setBool(const std::string& name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        set(handle(name), (int)value);
     }
     void setInt(const std::string& name, int value, bool useShader = false)
     {
         if (useShader)
             this->use();
-        glUniform1i(glGetUniformLocation(this->ID, name.c_str()), value);
+        set(handle(name), value);
     }
     void setFloat(const std::string& name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        set(handle(name), value);
     }
     void setVector2f(const char *name, float x, float y, bool useShader = false)
     {
         if (useShader)
             this->use();
-        glUniform2f(glGetUniformLocation(this->ID, name), x, y);
+        set(handle(name), glm::vec2(x, y));
     }
     void setVector2f(const char *name, const glm::vec2 &value, bool useShader = false)
     {
         if (useShader)
             this->use();
-        glUniform2f(glGetUniformLocation(this->ID, name), value.x, value.y);
+        set(handle(name), value);
     }
     void setVector3f(const char *name, float x, float y, float z, bool useShader = false)
     {
         if (useShader)
             this->use();
-        glUniform3f(glGetUniformLocation(this->ID, name), x, y, z);
+        set(handle(name), glm::vec3(x, y, z));
     }
     void setVector3f(const char *name, const glm::vec3 &value, bool useShader = false)
     {
         if (useShader)
             this->use();
-        glUniform3f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z);
+        set(handle(name), value);
     }
     void setVector4f(const char *name, float x, float y, float z, float w, bool useShader = false)
     {
         if (useShader)
             this->use();
-        glUniform4f(glGetUniformLocation(this->ID, name), x, y, z, w);
+        set(handle(name), glm::vec4(x, y, z, w));
     }
     void setVector4f(const char *name, const glm::vec4 &value, bool useShader = false)
     {
         if (useShader)
             this->use();
-        glUniform4f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z, value.w);
+        set(handle(name), value);
     }
     void setMat4(const std::string& name, const glm::mat4& mat, bool useShader = false)
     {
         if (useShader)
             this->use();
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        set(handle(name), mat);
     }
 
+private:
+    // uniform locations and last uploaded values, shared by all copies of a Shader
+    struct UniformTable
+    {
+        struct Value
+        {
+            unsigned char Data[sizeof(glm::mat4)];
+            std::size_t   Size; // 0 until the first upload
+        };
+        std::unordered_map<std::string, UniformHandle> Handles;
+        std::vector<Value> Values;
+
+        int addSlot()
+        {
+            Value value;
+            value.Size = 0;
+            Values.push_back(value);
+            return static_cast<int>(Values.size()) - 1;
+        }
+    };
+    std::shared_ptr<UniformTable> uniforms;
+
+    // records value as the uniform's current value; returns false if it already was
+    bool changed(UniformHandle handle, const void *value, std::size_t size) const
+    {
+        if (!handle.valid())
+            return false;
+        // glUniform* writes into the bound program, so only skip/remember uploads that really land in ours
+        if (handle.Slot < 0 || !uniforms || GLState::get().currentProgram() != ID)
+            return true;
+        UniformTable::Value &cached = uniforms->Values[handle.Slot];
+        if (cached.Size == size && std::memcmp(cached.Data, value, size) == 0)
+            return false;
+        std::memcpy(cached.Data, value, size);
+        cached.Size = size;
+        return true;
+    }
+    // builds the uniform table from all active uniforms of the linked program
+    void reflectUniforms()
+    {
+        uniforms = std::make_shared<UniformTable>();
+        int count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<char> name(maxLength > 0 ? maxLength : 1);
+        for (int i = 0; i < count; ++i)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, i, maxLength, &length, &size, &type, name.data());
+            std::string uniformName(name.data(), length);
+            int location = glGetUniformLocation(ID, uniformName.c_str());
+            if (location < 0)
+                continue; // member of a uniform block
+            UniformHandle handle(location, uniforms->addSlot());
+            uniforms->Handles[uniformName] = handle;
+            // arrays are reported as "name[0]"; make them reachable by their plain name too
+            std::size_t bracket = uniformName.find("[0]");
+            if (bracket != std::string::npos && bracket + 3 == uniformName.size())
+                uniforms->Handles[uniformName.substr(0, bracket)] = handle;
+        }
+    }
 private:
     // utility function for checking shader compilation/linking errors
     // ---------------------------------------------------------------